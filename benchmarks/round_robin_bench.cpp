@@ -0,0 +1,380 @@
+#include <benchmark/benchmark.h>
+#include "round_robin/round_robin.hpp"
+#include "round_robin/concurrent_round_robin.hpp"
+#include "round_robin/fair_queue.hpp"
+#include "round_robin/sharded_round_robin.hpp"
+#include "round_robin/static_round_robin.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// A payload large enough that moving it by value would show up
+struct Big {
+    int64_t payload[8];
+};
+
+using BigPtr = std::unique_ptr<Big>;
+
+template<typename T>
+struct Factory;
+
+template<>
+struct Factory<int> {
+    static int make(int64_t i) { return static_cast<int>(i); }
+};
+
+template<>
+struct Factory<BigPtr> {
+    static BigPtr make(int64_t i) {
+        auto big = std::make_unique<Big>();
+        big->payload[0] = i;
+        return big;
+    }
+};
+
+template<typename RR>
+using ValueOf = std::remove_pointer_t<decltype(std::declval<RR&>().try_next())>;
+
+template<typename T, typename RR>
+void fill_with(RR& rr, int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+        rr.add(Factory<T>::make(i));
+    }
+}
+
+template<typename RR>
+void fill(RR& rr, int64_t n) {
+    fill_with<ValueOf<RR>>(rr, n);
+}
+
+// add(): build a container of n items from scratch
+template<typename RR>
+void BM_Add(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    for (auto _ : state) {
+        RR rr;
+        fill(rr, n);
+        benchmark::DoNotOptimize(rr.size());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// add_range(): bulk-load n items in one call
+template<typename RR>
+void BM_AddRange(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    std::vector<int> source(static_cast<size_t>(n));
+    for (int64_t i = 0; i < n; ++i) {
+        source[static_cast<size_t>(i)] = static_cast<int>(i);
+    }
+    for (auto _ : state) {
+        RR rr;
+        rr.reserve(source.size());
+        rr.add_range(source.begin(), source.end());
+        benchmark::DoNotOptimize(rr.size());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// next(): one selection per iteration from a pool of n items
+template<typename RR>
+void BM_Next(benchmark::State& state) {
+    RR rr;
+    fill(rr, state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&rr.next());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// try_next(): as BM_Next, without the empty check and exception path
+template<typename RR>
+void BM_TryNext(benchmark::State& state) {
+    RR rr;
+    fill(rr, state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(rr.try_next());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// lease(): check an item out and return it, with half the pool leased meanwhile
+template<typename RR>
+void BM_LeaseReturn(benchmark::State& state) {
+    RR rr;
+    const int64_t n = state.range(0);
+    fill(rr, n);
+    std::vector<typename RR::Lease> held;
+    for (int64_t i = 0; i < n / 2; ++i) {
+        held.push_back(rr.lease());
+    }
+    for (auto _ : state) {
+        auto lease = rr.lease();
+        benchmark::DoNotOptimize(lease.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Deficit round-robin over n flows of which only 1 in 100 has a backlog
+static void BM_DeficitMostlyIdle(benchmark::State& state) {
+    rr::RoundRobin<int, rr::DeficitStorage> rr;
+    const int64_t n = state.range(0);
+    rr.reserve(static_cast<size_t>(n));
+    for (int64_t i = 0; i < n; ++i) {
+        rr::Handle handle = rr.add(static_cast<int>(i), 1500);
+        if (i % 100 != 0) {
+            rr.suspend(handle);
+        }
+    }
+    uint64_t cost = 64;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&rr.next());
+        rr.charge_current(cost);
+        cost = cost * 7 % 1500 + 64; // Varying request sizes
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Keyed lookup through the consistent-hash affinity index
+static void BM_NextForKey(benchmark::State& state) {
+    rr::RoundRobin<int, rr::VectorStorage, std::allocator<int>, rr::NoStats, rr::KeyAffinity> rr;
+    const int64_t n = state.range(0);
+    for (int64_t i = 0; i < n; ++i) {
+        rr.add(static_cast<int>(i));
+    }
+    uint64_t key = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&rr.next_for_key(key++));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// FairQueue push + pop over n keys, a few of them busy at a time
+static void BM_FairQueuePushPop(benchmark::State& state) {
+    rr::FairQueue<int64_t, int64_t> queue;
+    const int64_t n = state.range(0);
+    for (int64_t key = 0; key < n; ++key) {
+        queue.push(key, key);
+    }
+    int64_t key = 0;
+    for (auto _ : state) {
+        queue.push(key, key);
+        benchmark::DoNotOptimize(queue.pop());
+        key = (key * 31 + 7) % n;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// remove_current(): drain a pool of n items one selection at a time
+template<typename RR>
+void BM_RemoveCurrent(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    for (auto _ : state) {
+        state.PauseTiming();
+        RR rr;
+        fill(rr, n);
+        state.ResumeTiming();
+        while (!rr.empty()) {
+            rr.next();
+            rr.remove_current();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Churn: replace one item per iteration in a pool of n items
+template<typename RR>
+void BM_Churn(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    RR rr;
+    fill(rr, n);
+    int64_t i = 0;
+    for (auto _ : state) {
+        rr.next();
+        rr.remove_current();
+        rr.add(Factory<ValueOf<RR>>::make(i++));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Full cycle: visit all n items once with next()
+template<typename RR>
+void BM_FullCycle(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    RR rr;
+    fill(rr, n);
+    for (auto _ : state) {
+        for (int64_t i = 0; i < n; ++i) {
+            benchmark::DoNotOptimize(&rr.next());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Full cycle through the batch API
+template<typename RR>
+void BM_FullCycleBatch(benchmark::State& state) {
+    const int64_t n = state.range(0);
+    RR rr;
+    fill(rr, n);
+    for (auto _ : state) {
+        rr.for_each_next(static_cast<size_t>(n), [](auto& item) {
+            benchmark::DoNotOptimize(&item);
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Concurrent selection: every thread shares one pool
+template<typename T>
+rr::ConcurrentRoundRobin<T>& shared_pool(int64_t n) {
+    static rr::ConcurrentRoundRobin<T> pool;
+    static const bool filled = [n] {
+        fill_with<T>(pool, n);
+        return true;
+    }();
+    (void)filled;
+    return pool;
+}
+
+void BM_ConcurrentNext(benchmark::State& state) {
+    auto& pool = shared_pool<int>(64);
+    for (auto _ : state) {
+        auto ref = pool.next();
+        benchmark::DoNotOptimize(ref.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Load-aware selection; the guard completes at the end of each iteration
+void BM_ConcurrentLeastLoaded(benchmark::State& state) {
+    auto& pool = shared_pool<int>(64);
+    for (auto _ : state) {
+        auto pick = pool.next_least_loaded();
+        benchmark::DoNotOptimize(pick.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ConcurrentBatch(benchmark::State& state) {
+    auto& pool = shared_pool<int>(64);
+    const size_t batch = 64;
+    for (auto _ : state) {
+        pool.for_each_next(batch, [](int& item) { benchmark::DoNotOptimize(&item); });
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+// Sharded selection: each thread rotates over its own shard
+rr::ShardedRoundRobin<int>& sharded_pool(int64_t n) {
+    static rr::ShardedRoundRobin<int> pool;
+    static const bool filled = [n] {
+        fill_with<int>(pool, n);
+        return true;
+    }();
+    (void)filled;
+    return pool;
+}
+
+void BM_ShardedNext(benchmark::State& state) {
+    auto& pool = sharded_pool(64 * static_cast<int64_t>(std::thread::hardware_concurrency()));
+    for (auto _ : state) {
+        auto ref = pool.next();
+        benchmark::DoNotOptimize(ref.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ShardedBatch(benchmark::State& state) {
+    auto& pool = sharded_pool(64 * static_cast<int64_t>(std::thread::hardware_concurrency()));
+    const size_t batch = 64;
+    for (auto _ : state) {
+        pool.for_each_next(batch, [](int& item) { benchmark::DoNotOptimize(&item); });
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+// Polling a drained sharded pool: every call searches the other shards for
+// a victim to steal from before giving up, and empty() checks every shard
+void BM_ShardedSparsePoll(benchmark::State& state) {
+    const size_t shards = static_cast<size_t>(state.range(0));
+    rr::ShardedRoundRobin<int> pool(shards);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pool.try_next().get());
+        benchmark::DoNotOptimize(pool.empty());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+#define RR_BENCH_SIZES RangeMultiplier(32)->Range(1, 1 << 20)
+
+#define RR_BENCH_ALL(RR)                                                   \
+    BENCHMARK_TEMPLATE(BM_Add, RR)->RR_BENCH_SIZES;                        \
+    BENCHMARK_TEMPLATE(BM_Next, RR)->RR_BENCH_SIZES;                       \
+    BENCHMARK_TEMPLATE(BM_TryNext, RR)->RR_BENCH_SIZES;                    \
+    BENCHMARK_TEMPLATE(BM_RemoveCurrent, RR)->RR_BENCH_SIZES;              \
+    BENCHMARK_TEMPLATE(BM_Churn, RR)->RR_BENCH_SIZES;                      \
+    BENCHMARK_TEMPLATE(BM_FullCycle, RR)->RR_BENCH_SIZES;                  \
+    BENCHMARK_TEMPLATE(BM_FullCycleBatch, RR)->RR_BENCH_SIZES
+
+using ListInt = rr::RoundRobin<int, rr::ListStorage>;
+using VectorInt = rr::RoundRobin<int, rr::VectorStorage>;
+using WeightedInt = rr::RoundRobin<int, rr::WeightedStorage>;
+using PooledListInt = rr::PooledRoundRobin<int, rr::ListStorage>;
+using ListBig = rr::RoundRobin<BigPtr, rr::ListStorage>;
+using VectorBig = rr::RoundRobin<BigPtr, rr::VectorStorage>;
+
+RR_BENCH_ALL(ListInt);
+RR_BENCH_ALL(VectorInt);
+RR_BENCH_ALL(WeightedInt);
+RR_BENCH_ALL(PooledListInt);
+
+BENCHMARK_TEMPLATE(BM_AddRange, ListInt)->RR_BENCH_SIZES;
+BENCHMARK_TEMPLATE(BM_AddRange, VectorInt)->RR_BENCH_SIZES;
+BENCHMARK_TEMPLATE(BM_AddRange, PooledListInt)->RR_BENCH_SIZES;
+RR_BENCH_ALL(ListBig);
+RR_BENCH_ALL(VectorBig);
+
+// Fixed-capacity pools, full, with and without the power-of-two mask
+using StaticInt64 = rr::StaticRoundRobin<int, 64>;
+using StaticInt48 = rr::StaticRoundRobin<int, 48>;
+
+BENCHMARK_TEMPLATE(BM_Next, StaticInt64)->Arg(64);
+BENCHMARK_TEMPLATE(BM_Next, StaticInt48)->Arg(48);
+BENCHMARK_TEMPLATE(BM_Next, VectorInt)->Arg(64);
+BENCHMARK_TEMPLATE(BM_FullCycle, StaticInt64)->Arg(64);
+BENCHMARK_TEMPLATE(BM_FullCycle, StaticInt48)->Arg(48);
+
+BENCHMARK_TEMPLATE(BM_LeaseReturn, ListInt)->RR_BENCH_SIZES;
+BENCHMARK_TEMPLATE(BM_LeaseReturn, VectorInt)->RR_BENCH_SIZES;
+BENCHMARK_TEMPLATE(BM_LeaseReturn, WeightedInt)->RR_BENCH_SIZES;
+
+BENCHMARK(BM_DeficitMostlyIdle)->RangeMultiplier(32)->Range(1024, 1 << 20);
+BENCHMARK(BM_FairQueuePushPop)->RR_BENCH_SIZES;
+BENCHMARK(BM_NextForKey)->RangeMultiplier(32)->Range(1, 1 << 15);
+
+// Cost of the opt-in instrumentation, against VectorInt above
+using CountedVectorInt = rr::RoundRobin<int, rr::VectorStorage, std::allocator<int>, rr::SelectionStats<>>;
+using TimedVectorInt = rr::RoundRobin<int, rr::VectorStorage, std::allocator<int>, rr::TimedSelectionStats>;
+
+BENCHMARK_TEMPLATE(BM_Next, CountedVectorInt)->RR_BENCH_SIZES;
+BENCHMARK_TEMPLATE(BM_Next, TimedVectorInt)->RR_BENCH_SIZES;
+
+static const int max_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+BENCHMARK(BM_ConcurrentNext)->ThreadRange(1, max_threads)->UseRealTime();
+BENCHMARK(BM_ConcurrentLeastLoaded)->ThreadRange(1, max_threads)->UseRealTime();
+BENCHMARK(BM_ConcurrentBatch)->ThreadRange(1, max_threads)->UseRealTime();
+BENCHMARK(BM_ShardedNext)->ThreadRange(1, max_threads)->UseRealTime();
+BENCHMARK(BM_ShardedBatch)->ThreadRange(1, max_threads)->UseRealTime();
+BENCHMARK(BM_ShardedSparsePoll)->RangeMultiplier(8)->Range(8, 4096);
+
+BENCHMARK_MAIN();
@@ -1,38 +1,44 @@
-#include <round_robin/round_robin.hpp>
+#include <round_robin/concurrent_round_robin.hpp>
 #include <iostream>
+#include <string>
 #include <thread>
 #include <vector>
 #include <chrono>
 #include <atomic>
 
+// A queued task; the id tells apart tasks with equal names
+struct Task {
+    int id;
+    std::string name;
+};
+
 // Simulated worker that processes tasks
 class Worker {
-    rr::RoundRobin<std::string>& tasks_;
+    rr::ConcurrentRoundRobin<Task>& tasks_;
     int id_;
     std::atomic<bool>& should_stop_;
     
 public:
-    Worker(rr::RoundRobin<std::string>& tasks, int id, std::atomic<bool>& stop_flag)
+    Worker(rr::ConcurrentRoundRobin<Task>& tasks, int id, std::atomic<bool>& stop_flag)
         : tasks_(tasks), id_(id), should_stop_(stop_flag) {}
     
     void operator()() {
         while (!should_stop_) {
-            // Try to get and process a task
-            if (!tasks_.empty()) {
-                auto it = tasks_.begin();
-                if (it != tasks_.end()) {
-                    // Process the task
-                    std::cout << "Worker " << id_ << " processing: " << *it << '\n';
-                    
-                    // Simulate work
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                    
-                    // Remove the completed task
-                    it.remove_next();
-                }
-            } else {
-                // No tasks available, wait a bit
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            // Wait for a task; the timeout only bounds how long a stop request goes unnoticed
+            Task task{0, {}};
+            if (auto ref = tasks_.acquire(std::chrono::milliseconds(100))) {
+                task = *ref; // Copy it out so the Ref is released before removal
+            }
+            
+            // Claim the task by removing it. Removals are serialized, so only
+            // one worker removes it; the others find it gone and move on.
+            if (task.id != 0 &&
+                tasks_.remove_if([&](const Task& t) { return t.id == task.id; }) == 1) {
+                // Process the task
+                std::cout << "Worker " << id_ << " processing: " << task.name << '\n';
+                
+                // Simulate work
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
             }
         }
     }
@@ -40,14 +46,13 @@ public:
 
 int main() {
     // Create a shared task queue
-    rr::RoundRobin<std::string> tasks;
+    rr::ConcurrentRoundRobin<Task> tasks;
+    int next_id = 1;
     
     // Add initial tasks
-    tasks.add("Task 1");
-    tasks.add("Task 2");
-    tasks.add("Task 3");
-    tasks.add("Task 4");
-    tasks.add("Task 5");
+    for (int i = 0; i < 5; ++i) {
+        tasks.add(Task{next_id++, "Task " + std::to_string(i + 1)});
+    }
     
     // Create stop flag and workers
     std::atomic<bool> should_stop(false);
@@ -65,7 +70,7 @@ int main() {
         std::this_thread::sleep_for(std::chrono::milliseconds(300));
         auto task_name = "Dynamic Task " + std::to_string(i + 1);
         std::cout << "Adding new task: " << task_name << '\n';
-        tasks.add(std::move(task_name));
+        tasks.add(Task{next_id++, std::move(task_name)});
     }
     
     // Wait until most tasks are processed
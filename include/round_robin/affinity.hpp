@@ -0,0 +1,297 @@
+#ifndef ROUND_ROBIN_AFFINITY_HPP
+#define ROUND_ROBIN_AFFINITY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility> // For std::move, std::swap
+#include <vector>
+
+#include "round_robin/handle.hpp"
+
+namespace rr {
+
+/**
+ * @brief Affinity policy that keeps no index; the default for RoundRobin.
+ *
+ * Every hook is guarded by `if constexpr (Affinity::enabled)` in RoundRobin,
+ * so with this policy add() and remove() pay nothing for it.
+ */
+struct NoAffinity {
+    static constexpr bool enabled = false; ///< Whether RoundRobin calls the hooks.
+};
+
+/**
+ * @brief Affinity policy mapping key hashes to items by consistent hashing.
+ *
+ * The index is a lookup table of 2^k buckets, each owned by one item; a key
+ * hash is mixed and masked to pick its bucket, so a lookup is one load. Every
+ * item owns either floor(B/n) or ceil(B/n) of the B buckets. When an item is
+ * added it takes just enough buckets from the items holding the most, and when
+ * one is removed its buckets are dealt out to the items holding the fewest.
+ * No other bucket changes owner, so adding or removing one of n items moves
+ * about 1/n of the keys, and only keys of the items involved.
+ *
+ * The table keeps at least buckets_per_item buckets per item, which bounds
+ * the imbalance between items to about 1/buckets_per_item. It doubles as the
+ * item count grows; doubling copies each bucket's owner into its new twin, so
+ * it moves no key. It never shrinks.
+ *
+ * An add only enters the item; its buckets are dealt out at the next lookup
+ * or removal, so a run of adds (or add_range()) is indexed in one step.
+ * Items are grouped by the number of buckets they own, so dealing out and
+ * removal only touch the buckets that change owner, O(B/n) per item, plus
+ * O(n) whenever the table doubles.
+ */
+class KeyAffinity {
+public:
+    static constexpr bool enabled = true; ///< Whether RoundRobin calls the hooks.
+    static constexpr size_t buckets_per_item = 32; ///< Lower bound on table size per item.
+    static constexpr size_t min_buckets = 64; ///< Size of the first table.
+
+private:
+    static constexpr uint32_t no_member = UINT32_MAX;
+
+    /**
+     * @struct Member
+     * @brief An item in the index, with the buckets it owns.
+     */
+    struct Member {
+        Handle handle; ///< The item.
+        std::vector<uint32_t> buckets; ///< Buckets owned by the item, in no particular order.
+        size_t tier_pos = 0; ///< Position in tiers_[buckets.size()].
+    };
+
+    std::vector<uint32_t> table_; ///< Owner of each bucket, as an index into members_.
+    std::vector<Member> members_; ///< Items in the index, in no particular order.
+    std::vector<uint32_t> member_of_; ///< Position in members_ by Handle::index, or no_member.
+    std::vector<uint32_t> orphans_; ///< Buckets waiting for an owner; only non-empty while members_ is.
+    std::map<size_t, std::vector<uint32_t>> tiers_; ///< Positions in members_ by number of buckets owned.
+    size_t tiered_ = 0; ///< Members entered in tiers_; those after it were added since the last settle().
+
+    /**
+     * @brief Spreads key hashes over the table, so that weak hashes (small
+     *        integers, pointers) still use every bucket.
+     */
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    void assign(uint32_t bucket, uint32_t position) {
+        table_[bucket] = position;
+        members_[position].buckets.push_back(bucket);
+    }
+
+    void tier_insert(uint32_t position) {
+        std::vector<uint32_t>& tier = tiers_[members_[position].buckets.size()];
+        members_[position].tier_pos = tier.size();
+        tier.push_back(position);
+    }
+
+    void tier_erase(uint32_t position) {
+        auto it = tiers_.find(members_[position].buckets.size());
+        std::vector<uint32_t>& tier = it->second;
+        uint32_t moved = tier.back();
+        tier[members_[position].tier_pos] = moved;
+        members_[moved].tier_pos = members_[position].tier_pos;
+        tier.pop_back();
+        if (tier.empty()) {
+            tiers_.erase(it);
+        }
+    }
+
+    /**
+     * @brief Doubles the table; bucket b + B gets the owner of bucket b.
+     */
+    void grow() {
+        const uint32_t size = static_cast<uint32_t>(table_.size());
+        table_.resize(size * 2, no_member);
+        for (uint32_t bucket = 0; bucket < size; ++bucket) {
+            uint32_t owner = table_[bucket];
+            if (owner == no_member) {
+                orphans_.push_back(bucket + size);
+            } else {
+                assign(bucket + size, owner);
+            }
+        }
+    }
+
+    /**
+     * @brief Deals out buckets to the members added since the last call.
+     *
+     * The new members start with no buckets. Taking turns, each takes one
+     * bucket from a member holding the most, until no old member holds more
+     * than one above it. Old members never drop below the new ones, so every
+     * member ends with floor(B/n) or ceil(B/n) and only the new members gain.
+     */
+    void settle() {
+        const size_t olds = tiered_;
+        const size_t count = members_.size();
+        if (olds == count) {
+            return;
+        }
+        if (table_.empty()) {
+            table_.assign(min_buckets, no_member);
+            for (uint32_t bucket = 0; bucket < min_buckets; ++bucket) {
+                orphans_.push_back(bucket);
+            }
+        }
+        if (table_.size() < count * buckets_per_item) {
+            while (table_.size() < count * buckets_per_item) {
+                grow();
+            }
+            tiers_.clear();
+            for (size_t i = 0; i < olds; ++i) {
+                tier_insert(static_cast<uint32_t>(i));
+            }
+        }
+
+        // Buckets without an owner only exist while there were no members
+        size_t next = olds;
+        for (uint32_t bucket : orphans_) {
+            assign(bucket, static_cast<uint32_t>(next));
+            next = next + 1 == count ? olds : next + 1;
+        }
+        orphans_.clear();
+
+        for (bool taking = olds != 0; taking;) {
+            for (size_t i = olds; i < count; ++i) {
+                uint32_t donor = tiers_.rbegin()->second.back();
+                if (members_[donor].buckets.size() <= members_[i].buckets.size() + 1) {
+                    taking = false;
+                    break;
+                }
+                tier_erase(donor);
+                assign(members_[donor].buckets.back(), static_cast<uint32_t>(i));
+                members_[donor].buckets.pop_back();
+                tier_insert(donor);
+            }
+        }
+        for (; tiered_ < count; ++tiered_) {
+            tier_insert(static_cast<uint32_t>(tiered_));
+        }
+    }
+
+public:
+    KeyAffinity() = default;
+
+    KeyAffinity(KeyAffinity&& other) noexcept {
+        swap(other);
+    }
+
+    KeyAffinity& operator=(KeyAffinity&& other) noexcept {
+        if (this != &other) {
+            KeyAffinity(std::move(other)).swap(*this);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Enters a newly added item into the index.
+     * @param handle The item's handle.
+     *
+     * O(1); the item gets its buckets at the next lookup() or on_remove().
+     */
+    void on_add(Handle handle) {
+        if (handle.index >= member_of_.size()) {
+            member_of_.resize(handle.index + 1, no_member);
+        }
+        member_of_[handle.index] = static_cast<uint32_t>(members_.size());
+        members_.push_back(Member{handle, {}, 0});
+    }
+
+    /**
+     * @brief Reserves room for n items in the index.
+     * @param n Total number of items to make room for.
+     */
+    void reserve(size_t n) {
+        members_.reserve(n);
+        member_of_.reserve(n);
+    }
+
+    /**
+     * @brief Takes a removed item out of the index.
+     * @param slot The item's Handle::index.
+     */
+    void on_remove(uint32_t slot) {
+        settle();
+        uint32_t position = member_of_[slot];
+        member_of_[slot] = no_member;
+        tier_erase(position);
+        std::vector<uint32_t> pool = std::move(members_[position].buckets);
+
+        // Fill the gap with the last member, whose buckets then change position
+        uint32_t last = static_cast<uint32_t>(members_.size() - 1);
+        if (position != last) {
+            members_[position] = std::move(members_[last]);
+            Member& moved = members_[position];
+            member_of_[moved.handle.index] = position;
+            tiers_[moved.buckets.size()][moved.tier_pos] = position;
+            for (uint32_t bucket : moved.buckets) {
+                table_[bucket] = position;
+            }
+        }
+        members_.pop_back();
+        tiered_ = members_.size();
+
+        if (members_.empty()) {
+            for (uint32_t bucket : pool) {
+                table_[bucket] = no_member;
+            }
+            orphans_.insert(orphans_.end(), pool.begin(), pool.end());
+            return;
+        }
+        for (uint32_t bucket : pool) {
+            uint32_t recipient = tiers_.begin()->second.back();
+            tier_erase(recipient);
+            assign(bucket, recipient);
+            tier_insert(recipient);
+        }
+    }
+
+    /**
+     * @brief Finds the item a key maps to.
+     * @param key_hash Hash of the key.
+     * @param probe 0 for the key's own item; 1, 2, ... for its fallbacks,
+     *        which are spread over the other items by rehashing.
+     * @return The item's handle, or a default Handle if the index is empty.
+     *
+     * Deals out buckets to the items added since the previous call first.
+     */
+    Handle lookup(uint64_t key_hash, uint64_t probe) {
+        settle();
+        if (members_.empty()) {
+            return Handle{};
+        }
+        uint64_t bucket = mix(key_hash + probe * 0x9E3779B97F4A7C15ull) & (table_.size() - 1);
+        return members_[table_[bucket]].handle;
+    }
+
+    /**
+     * @brief Retrieves the number of buckets in the table.
+     */
+    size_t bucket_count() const {
+        return table_.size();
+    }
+
+    /**
+     * @brief Exchanges the contents of two indexes.
+     */
+    void swap(KeyAffinity& other) noexcept {
+        table_.swap(other.table_);
+        members_.swap(other.members_);
+        member_of_.swap(other.member_of_);
+        orphans_.swap(other.orphans_);
+        tiers_.swap(other.tiers_);
+        std::swap(tiered_, other.tiered_);
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_AFFINITY_HPP
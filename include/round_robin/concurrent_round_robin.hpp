@@ -0,0 +1,790 @@
+#ifndef ROUND_ROBIN_CONCURRENT_ROUND_ROBIN_HPP
+#define ROUND_ROBIN_CONCURRENT_ROUND_ROBIN_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional> // For std::hash
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility> // For std::move
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define ROUND_ROBIN_HAS_COROUTINES 1
+#endif
+
+namespace rr {
+
+/**
+ * @brief A round-robin container that many threads can use at once.
+ *
+ * Selecting an item is one atomic fetch-add on a shared ticket counter, taken
+ * modulo the number of items. With a stable item set, any window of size()
+ * consecutive selections returns every item exactly once, no matter how many
+ * threads take part.
+ *
+ * Readers never block. Writers (add(), add_range(), assign(), remove_if())
+ * are serialized by a mutex. Each one copies the current item list into a new
+ * immutable snapshot, publishes it with a single atomic store, and then waits
+ * for a grace period before freeing the old one. A grace period ends once every
+ * reader that might still be looking at the old snapshot has released its Ref.
+ * Writes cost O(n), which suits pools that are read far more often than they
+ * change; add_range() and assign() publish many changes for the price of one.
+ *
+ * A Ref keeps its item alive. Holding a Ref while calling a writer on the
+ * same thread deadlocks, because the writer waits for that Ref.
+ *
+ * The container can be moved like RoundRobin, keeping its items and its place
+ * in the rotation, but only while no other thread uses either side and no Ref
+ * into either is alive.
+ *
+ * Callers that would rather wait than get nothing from an empty pool can park
+ * in acquire(), or in `co_await async_next()` when built as C++20. They are
+ * woken by the write that makes the pool non-empty. Writers only check an
+ * atomic waiter count, so as long as nobody waits they take no extra lock and
+ * make no system call.
+ *
+ * For backends of uneven speed, try_next_least_loaded() picks the less busy
+ * of two candidates instead of strictly rotating, and returns an InFlight
+ * guard that counts the item as busy until the work is done.
+ *
+ * @tparam T The type of items stored in the round-robin container.
+ */
+template<typename T>
+class ConcurrentRoundRobin {
+private:
+    /**
+     * @struct Node
+     * @brief An item together with its in-flight count, shared between snapshots.
+     */
+    struct Node {
+        T value; ///< The stored item.
+        std::atomic<uint32_t> in_flight{0}; ///< Live InFlight guards for this item.
+
+        template<typename... Args>
+        explicit Node(Args&&... args) : value(std::forward<Args>(args)...) {}
+    };
+
+    /**
+     * @struct Snapshot
+     * @brief Immutable item list shared by readers until it is replaced.
+     */
+    struct Snapshot {
+        std::vector<std::shared_ptr<Node>> items; ///< Items in rotation order.
+    };
+
+    /**
+     * @struct ReaderCount
+     * @brief Count of readers in one phase, padded to its own cache line.
+     */
+    struct alignas(64) ReaderCount {
+        std::atomic<size_t> value{0}; ///< Number of readers currently inside a read section.
+    };
+
+    static constexpr size_t stripes = 16; ///< Reader counters per phase, spread to avoid contention.
+
+#ifdef ROUND_ROBIN_HAS_COROUTINES
+public:
+    class AsyncNext;
+
+private:
+#endif
+
+    std::atomic<Snapshot*> snapshot_; ///< The snapshot readers currently rotate over.
+    std::atomic<size_t> ticket_{0}; ///< Ticket counter shared by all readers.
+    std::atomic<size_t> size_{0}; ///< Number of items in the published snapshot.
+    std::atomic<unsigned> phase_{0}; ///< Selects which reader counters new readers register in.
+    ReaderCount readers_[2][stripes]; ///< Reader counters, indexed by phase and thread stripe.
+    std::mutex write_mutex_; ///< Serializes writers.
+    std::atomic<size_t> waiters_{0}; ///< Callers parked in acquire() or async_next().
+    std::mutex wait_mutex_; ///< Guards parking and waking.
+    std::condition_variable wait_cv_; ///< Signalled when the pool becomes non-empty.
+#ifdef ROUND_ROBIN_HAS_COROUTINES
+    AsyncNext* async_waiters_ = nullptr; ///< Suspended coroutines, most recent first.
+#endif
+
+    /**
+     * @brief Returns the shared empty snapshot, which is never freed.
+     *
+     * Empty and moved-from containers point at it, so neither construction nor
+     * a move allocates and readers need no null check.
+     */
+    static Snapshot* empty_snapshot() {
+        static Snapshot empty;
+        return &empty;
+    }
+
+    /**
+     * @brief Frees a snapshot no reader can see any more.
+     */
+    static void retire(Snapshot* snapshot) {
+        if (snapshot != empty_snapshot()) {
+            delete snapshot;
+        }
+    }
+
+    /**
+     * @brief Returns the reader counter stripe used by the calling thread.
+     */
+    static size_t stripe_index() {
+        static thread_local const size_t stripe =
+            std::hash<std::thread::id>{}(std::this_thread::get_id()) % stripes;
+        return stripe;
+    }
+
+    /**
+     * @brief Registers the calling thread as a reader.
+     * @return The counter that must be decremented when the read section ends.
+     */
+    std::atomic<size_t>& enter_read() {
+        auto& counter = readers_[phase_.load() & 1u][stripe_index()].value;
+        counter.fetch_add(1);
+        return counter;
+    }
+
+    /**
+     * @brief Waits until every reader registered in the given phase has left.
+     */
+    void wait_for_readers(unsigned phase) {
+        for (auto& counter : readers_[phase]) {
+            while (counter.value.load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * @brief Waits until no reader can still be using a replaced snapshot.
+     *
+     * Flipping the phase sends new readers to the other set of counters, so
+     * the wait on the old set cannot be starved. Two flips are needed: a
+     * reader that read the phase just before the first flip may register in
+     * the new set and still load the old snapshot pointer.
+     */
+    void synchronize() {
+        for (int i = 0; i < 2; ++i) {
+            unsigned old_phase = phase_.fetch_add(1) & 1u;
+            wait_for_readers(old_phase);
+        }
+    }
+
+    /**
+     * @brief Publishes a new snapshot and frees the old one after a grace period.
+     * @param next The snapshot to publish. Ownership is transferred.
+     *
+     * Must be called with write_mutex_ held.
+     */
+    void publish(std::unique_ptr<Snapshot> next) {
+        size_.store(next->items.size());
+        Snapshot* old = snapshot_.exchange(next.release());
+        synchronize();
+        retire(old);
+    }
+
+    /**
+     * @brief Hands the pool to parked callers after a write, then ends the write.
+     * @param write_lock The writer's lock on write_mutex_, released here.
+     *
+     * Waiters only park while the pool is empty, and an item stays in the pool
+     * once selected, so every waiter can be served. Blocked threads are woken
+     * with a single broadcast. Suspended coroutines are taken off the list here
+     * and resumed on this thread once the write lock is released, each with an
+     * item selected just before its resumption. No Ref is held for a coroutine
+     * still waiting its turn, so a resumed coroutine may write to the pool. One
+     * that finds the pool emptied again parks until the next write. A burst of
+     * adds only finds waiters on its first write, so it does not wake anyone
+     * repeatedly.
+     *
+     * The waiter count is read after the snapshot is published; waiters
+     * register before checking the snapshot. With both sequentially consistent,
+     * either this sees the waiter or the waiter sees the new snapshot.
+     */
+    void wake_waiters(std::unique_lock<std::mutex> write_lock) {
+        if (waiters_.load() == 0 || size_.load() == 0) {
+            return;
+        }
+#ifdef ROUND_ROBIN_HAS_COROUTINES
+        AsyncNext* ready;
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            ready = async_waiters_;
+            async_waiters_ = nullptr;
+            for (AsyncNext* waiter = ready; waiter; waiter = waiter->next_waiter_) {
+                waiters_.fetch_sub(1);
+            }
+        }
+        wait_cv_.notify_all();
+        write_lock.unlock();
+        while (ready) {
+            AsyncNext* waiter = ready;
+            ready = ready->next_waiter_; // The waiter may be gone once resumed
+            if (!(waiter->result_ = try_next()) && waiter->park()) {
+                continue; // Emptied by an earlier waiter; the next write resumes it
+            }
+            waiter->handle_.resume();
+        }
+#else
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+        }
+        wait_cv_.notify_all();
+        write_lock.unlock();
+#endif
+    }
+
+    /**
+     * @brief Publishes a snapshot with one more item appended.
+     */
+    void add_shared(std::shared_ptr<Node> item) {
+        std::unique_lock<std::mutex> lock(write_mutex_);
+        const Snapshot* current = snapshot_.load();
+        auto next = std::make_unique<Snapshot>();
+        next->items.reserve(current->items.size() + 1);
+        next->items.assign(current->items.begin(), current->items.end());
+        next->items.push_back(std::move(item));
+        publish(std::move(next));
+        wake_waiters(std::move(lock));
+    }
+
+    /**
+     * @brief Wraps each item of a range for sharing between snapshots.
+     */
+    template<typename InputIt>
+    static void append_shared(std::vector<std::shared_ptr<Node>>& items, InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            items.push_back(std::make_shared<Node>(*first));
+        }
+    }
+
+public:
+    /**
+     * @class Ref
+     * @brief Guarded reference to a selected item.
+     *
+     * While a Ref is alive the item it refers to is kept alive, even if a
+     * writer removes it from the container in the meantime. An empty Ref is
+     * returned by try_next() when the container is empty.
+     */
+    class Ref {
+    private:
+        std::atomic<size_t>* reader_ = nullptr; ///< Reader counter to release, if any.
+        T* item_ = nullptr; ///< The selected item, or nullptr.
+
+        friend class ConcurrentRoundRobin;
+
+        Ref(std::atomic<size_t>* reader, T* item) : reader_(reader), item_(item) {}
+
+    public:
+        /**
+         * @brief Constructs an empty Ref.
+         */
+        Ref() = default;
+
+        /**
+         * @brief Move constructor, transferring the guard.
+         * @param other The Ref to move from.
+         */
+        Ref(Ref&& other) noexcept : reader_(other.reader_), item_(other.item_) {
+            other.reader_ = nullptr;
+            other.item_ = nullptr;
+        }
+
+        /**
+         * @brief Move assignment operator, releasing the current guard first.
+         * @param other The Ref to move from.
+         * @return Reference to this Ref after the move.
+         */
+        Ref& operator=(Ref&& other) noexcept {
+            if (this != &other) {
+                reset();
+                reader_ = other.reader_;
+                item_ = other.item_;
+                other.reader_ = nullptr;
+                other.item_ = nullptr;
+            }
+            return *this;
+        }
+
+        Ref(const Ref&) = delete;
+        Ref& operator=(const Ref&) = delete;
+
+        /**
+         * @brief Destructor, ending the read section.
+         */
+        ~Ref() {
+            reset();
+        }
+
+        /**
+         * @brief Releases the item early. The Ref becomes empty.
+         */
+        void reset() {
+            if (reader_) {
+                reader_->fetch_sub(1);
+                reader_ = nullptr;
+            }
+            item_ = nullptr;
+        }
+
+        /**
+         * @brief Returns a pointer to the item, or nullptr if the Ref is empty.
+         */
+        T* get() const {
+            return item_;
+        }
+
+        /**
+         * @brief Checks whether the Ref refers to an item.
+         */
+        explicit operator bool() const {
+            return item_ != nullptr;
+        }
+
+        T& operator*() const {
+            return *item_;
+        }
+
+        T* operator->() const {
+            return item_;
+        }
+    };
+
+    /**
+     * @class InFlight
+     * @brief Marks an item selected by try_next_least_loaded() as busy.
+     *
+     * The item counts as in flight until complete() is called or the guard is
+     * destroyed. The guard owns a reference to the item, so the item stays
+     * valid even if it is removed meanwhile, and unlike a Ref it does not
+     * delay writers. It may be completed on any thread.
+     */
+    class InFlight {
+    private:
+        std::shared_ptr<Node> node_; ///< The busy item, or null.
+
+        friend class ConcurrentRoundRobin;
+
+        explicit InFlight(std::shared_ptr<Node> node) : node_(std::move(node)) {}
+
+    public:
+        /**
+         * @brief Constructs an empty guard.
+         */
+        InFlight() = default;
+
+        InFlight(InFlight&&) noexcept = default;
+
+        /**
+         * @brief Move assignment operator, completing the current item first.
+         * @param other The guard to move from.
+         * @return Reference to this guard after the move.
+         */
+        InFlight& operator=(InFlight&& other) noexcept {
+            if (this != &other) {
+                complete();
+                node_ = std::move(other.node_);
+            }
+            return *this;
+        }
+
+        InFlight(const InFlight&) = delete;
+        InFlight& operator=(const InFlight&) = delete;
+
+        /**
+         * @brief Destructor, completing the item if that was not done yet.
+         */
+        ~InFlight() {
+            complete();
+        }
+
+        /**
+         * @brief Marks the work on the item as done. The guard becomes empty.
+         */
+        void complete() {
+            if (node_) {
+                node_->in_flight.fetch_sub(1, std::memory_order_relaxed);
+                node_.reset();
+            }
+        }
+
+        /**
+         * @brief Retrieves the number of guards, this one included, on the item.
+         */
+        size_t in_flight() const {
+            return node_ ? node_->in_flight.load(std::memory_order_relaxed) : 0;
+        }
+
+        /**
+         * @brief Returns a pointer to the item, or nullptr if the guard is empty.
+         */
+        T* get() const {
+            return node_ ? &node_->value : nullptr;
+        }
+
+        /**
+         * @brief Checks whether the guard refers to an item.
+         */
+        explicit operator bool() const {
+            return node_ != nullptr;
+        }
+
+        T& operator*() const {
+            return node_->value;
+        }
+
+        T* operator->() const {
+            return &node_->value;
+        }
+    };
+
+    /**
+     * @brief Default constructor, initializing an empty container.
+     */
+    ConcurrentRoundRobin() noexcept : snapshot_(empty_snapshot()) {}
+
+    /**
+     * @brief Destructor. No Ref may outlive the container.
+     */
+    ~ConcurrentRoundRobin() {
+        retire(snapshot_.load());
+    }
+
+    /**
+     * @brief Move constructor, taking over the items and the rotation position.
+     * @param other The container to move from; left empty.
+     *
+     * Neither container may be in use by another thread, and no Ref into other
+     * may be alive.
+     */
+    ConcurrentRoundRobin(ConcurrentRoundRobin&& other) noexcept
+        : snapshot_(other.snapshot_.exchange(empty_snapshot()))
+        , ticket_(other.ticket_.exchange(0))
+        , size_(other.size_.exchange(0)) {}
+
+    /**
+     * @brief Move assignment operator, taking over the items and the rotation position.
+     * @param other The container to move from; left empty.
+     * @return Reference to this container after the move.
+     *
+     * Neither container may be in use by another thread, and no Ref into
+     * either may be alive. The items previously held are destroyed.
+     */
+    ConcurrentRoundRobin& operator=(ConcurrentRoundRobin&& other) noexcept {
+        if (this != &other) {
+            retire(snapshot_.exchange(other.snapshot_.exchange(empty_snapshot())));
+            ticket_.store(other.ticket_.exchange(0));
+            size_.store(other.size_.exchange(0));
+        }
+        return *this;
+    }
+
+    // Copying would have to copy every item; use assign() with a range instead
+    ConcurrentRoundRobin(const ConcurrentRoundRobin&) = delete;
+    ConcurrentRoundRobin& operator=(const ConcurrentRoundRobin&) = delete;
+
+    /**
+     * @brief Adds a copyable item to the container.
+     * @param item The item to add, copied into the container.
+     */
+    void add(const T& item) {
+        add_shared(std::make_shared<Node>(item));
+    }
+
+    /**
+     * @brief Adds a movable item to the container.
+     * @param item The item to add, moved into the container.
+     */
+    void add(T&& item) {
+        add_shared(std::make_shared<Node>(std::move(item)));
+    }
+
+    /**
+     * @brief Appends a range of items, publishing a single new snapshot.
+     * @param first Iterator to the first item to add.
+     * @param last Iterator past the last item to add.
+     */
+    template<typename InputIt>
+    void add_range(InputIt first, InputIt last) {
+        std::unique_lock<std::mutex> lock(write_mutex_);
+        const Snapshot* current = snapshot_.load();
+        auto next = std::make_unique<Snapshot>();
+        next->items.assign(current->items.begin(), current->items.end());
+        append_shared(next->items, first, last);
+        if (next->items.size() != current->items.size()) {
+            publish(std::move(next));
+            wake_waiters(std::move(lock));
+        }
+    }
+
+    /**
+     * @brief Replaces all items with a range, publishing a single new snapshot.
+     * @param first Iterator to the first new item.
+     * @param last Iterator past the last new item.
+     *
+     * Readers see either the old item set or the new one, never a mix. The
+     * rotation continues from its current ticket. Readers holding a Ref to an
+     * old item keep using it safely, as with remove_if().
+     */
+    template<typename InputIt>
+    void assign(InputIt first, InputIt last) {
+        auto next = std::make_unique<Snapshot>();
+        append_shared(next->items, first, last);
+        std::unique_lock<std::mutex> lock(write_mutex_);
+        publish(std::move(next));
+        wake_waiters(std::move(lock));
+    }
+
+    /**
+     * @brief Removes every item matching a predicate.
+     * @param pred Called with a const reference to each item.
+     * @return The number of items removed.
+     *
+     * Readers holding a Ref to a removed item keep using it safely; the item
+     * is destroyed once the last snapshot referring to it is freed.
+     */
+    template<typename Pred>
+    size_t remove_if(Pred pred) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        const Snapshot* current = snapshot_.load();
+        auto next = std::make_unique<Snapshot>();
+        next->items.reserve(current->items.size());
+        for (const auto& item : current->items) {
+            if (!pred(static_cast<const T&>(item->value))) {
+                next->items.push_back(item);
+            }
+        }
+        size_t removed = current->items.size() - next->items.size();
+        if (removed != 0) {
+            publish(std::move(next));
+        }
+        return removed;
+    }
+
+    /**
+     * @brief Attempts to retrieve the next item in the round-robin cycle.
+     * @return A Ref to the next item, or an empty Ref if the container is empty.
+     *
+     * Lock-free: one fetch-add on the ticket counter selects the item.
+     */
+    Ref try_next() {
+        auto& reader = enter_read();
+        const Snapshot* snapshot = snapshot_.load();
+        const size_t count = snapshot->items.size();
+        if (count == 0) {
+            reader.fetch_sub(1);
+            return Ref();
+        }
+        size_t ticket = ticket_.fetch_add(1, std::memory_order_relaxed);
+        return Ref(&reader, &snapshot->items[ticket % count]->value);
+    }
+
+    /**
+     * @brief Selects the less busy of two items and counts it as in flight.
+     * @return An InFlight guard for the item, or an empty guard if the container is empty.
+     *
+     * Power-of-two-choices: the first candidate is the one try_next() would
+     * return, the second is derived from the same ticket by hashing. The item
+     * with fewer live InFlight guards wins, ties going to the rotation, so
+     * with even load this is plain round-robin and a stalled item is skipped
+     * until its requests complete. Lock-free and O(1): one fetch-add on the
+     * ticket, two loads, one fetch-add on the winner's count.
+     *
+     * Only guards from this call are counted; try_next() and for_each_next()
+     * neither see nor change the counts. The guard does not hold a read
+     * section, so writers are not held up by long requests.
+     */
+    InFlight try_next_least_loaded() {
+        Ref section(&enter_read(), nullptr);
+        const Snapshot* snapshot = snapshot_.load();
+        const size_t count = snapshot->items.size();
+        if (count == 0) {
+            return InFlight();
+        }
+        uint64_t ticket = ticket_.fetch_add(1, std::memory_order_relaxed);
+        const std::shared_ptr<Node>* pick = &snapshot->items[ticket % count];
+        if (count > 1) {
+            uint64_t mixed = ticket * 0x9E3779B97F4A7C15ull;
+            size_t offset = 1 + static_cast<size_t>((mixed >> 32) % (count - 1));
+            const std::shared_ptr<Node>& other = snapshot->items[(ticket + offset) % count];
+            if (other->in_flight.load(std::memory_order_relaxed) < (*pick)->in_flight.load(std::memory_order_relaxed)) {
+                pick = &other;
+            }
+        }
+        (*pick)->in_flight.fetch_add(1, std::memory_order_relaxed);
+        return InFlight(*pick);
+    }
+
+    /**
+     * @brief Selects the less busy of two items, throwing if the container is empty.
+     * @return An InFlight guard for the item.
+     */
+    InFlight next_least_loaded() {
+        InFlight result = try_next_least_loaded();
+        if (!result) {
+            throw std::runtime_error("Attempted to get next item from empty ConcurrentRoundRobin");
+        }
+        return result;
+    }
+
+    /**
+     * @brief Calls fn on each of the next n items of the rotation.
+     * @param n Number of items to visit.
+     * @param fn Called with a T& for each item. It must not call add() or
+     *           remove_if() on this container.
+     * @return n, or 0 if the container is empty.
+     *
+     * The whole batch reserves its n tickets with a single fetch-add, so the
+     * items are consecutive in the rotation even when other threads are
+     * selecting at the same time.
+     */
+    template<typename Fn>
+    size_t for_each_next(size_t n, Fn&& fn) {
+        Ref section(&enter_read(), nullptr); // Ends the read section on return or throw
+        const Snapshot* snapshot = snapshot_.load();
+        const size_t count = snapshot->items.size();
+        if (count == 0) {
+            return 0;
+        }
+        size_t index = ticket_.fetch_add(n, std::memory_order_relaxed) % count;
+        for (size_t i = 0; i < n; ++i) {
+            fn(snapshot->items[index]->value);
+            if (++index == count) {
+                index = 0;
+            }
+        }
+        return n;
+    }
+
+    /**
+     * @brief Retrieves the next item in the round-robin cycle, throwing if the container is empty.
+     * @return A Ref to the next item.
+     */
+    Ref next() {
+        Ref result = try_next();
+        if (!result) {
+            throw std::runtime_error("Attempted to get next item from empty ConcurrentRoundRobin");
+        }
+        return result;
+    }
+
+    /**
+     * @brief Retrieves the next item, waiting for one to be added if the container is empty.
+     * @param timeout How long to wait at most.
+     * @return A Ref to the next item, or an empty Ref if the container stayed
+     *         empty for the whole timeout.
+     *
+     * Returns at once, without locking, if the container is not empty.
+     * Otherwise the calling thread sleeps until a writer makes it non-empty.
+     */
+    template<typename Rep, typename Period>
+    Ref acquire(const std::chrono::duration<Rep, Period>& timeout) {
+        if (Ref ref = try_next()) {
+            return ref;
+        }
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        Ref ref;
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        waiters_.fetch_add(1);
+        while (!(ref = try_next())) {
+            if (wait_cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                ref = try_next();
+                break;
+            }
+        }
+        waiters_.fetch_sub(1);
+        return ref;
+    }
+
+#ifdef ROUND_ROBIN_HAS_COROUTINES
+    /**
+     * @class AsyncNext
+     * @brief Awaitable returned by async_next(); resolves to a Ref.
+     */
+    class AsyncNext {
+    private:
+        ConcurrentRoundRobin* owner_; ///< The container to select from.
+        Ref result_; ///< The selected item, filled in before resumption.
+        std::coroutine_handle<> handle_; ///< The suspended coroutine.
+        AsyncNext* next_waiter_ = nullptr; ///< Next suspended coroutine in the owner's list.
+
+        friend class ConcurrentRoundRobin;
+
+        explicit AsyncNext(ConcurrentRoundRobin* owner) : owner_(owner) {}
+
+        /**
+         * @brief Adds this awaiter to the owner's waiters unless an item can be selected.
+         * @return True if parked, false if result_ now holds an item.
+         */
+        bool park() {
+            std::lock_guard<std::mutex> lock(owner_->wait_mutex_);
+            owner_->waiters_.fetch_add(1);
+            if ((result_ = owner_->try_next())) {
+                owner_->waiters_.fetch_sub(1);
+                return false;
+            }
+            next_waiter_ = owner_->async_waiters_;
+            owner_->async_waiters_ = this;
+            return true;
+        }
+
+    public:
+        AsyncNext(const AsyncNext&) = delete;
+        AsyncNext& operator=(const AsyncNext&) = delete;
+
+        bool await_ready() {
+            result_ = owner_->try_next();
+            return static_cast<bool>(result_);
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            handle_ = handle;
+            return park(); // False if an item arrived meanwhile; do not suspend
+        }
+
+        Ref await_resume() {
+            return std::move(result_);
+        }
+    };
+
+    /**
+     * @brief Awaits the next item, suspending the coroutine while the container is empty.
+     * @return An awaitable; `co_await rr.async_next()` yields a non-empty Ref.
+     *
+     * Completes without suspending if the container is not empty. Otherwise
+     * the coroutine is resumed inline, on the thread whose add(), add_range()
+     * or assign() made the container non-empty, after that call has released
+     * its locks. The resumed coroutine may itself write to the container once
+     * it no longer holds its Ref. A suspended coroutine must not be destroyed,
+     * and the container must outlive it.
+     */
+    AsyncNext async_next() {
+        return AsyncNext(this);
+    }
+#endif
+
+    /**
+     * @brief Checks if the container is empty.
+     * @return True if the container is empty, false otherwise.
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Retrieves the number of items in the container.
+     * @return The count of items in the most recently published snapshot.
+     */
+    size_t size() const {
+        return size_.load();
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_CONCURRENT_ROUND_ROBIN_HPP
@@ -0,0 +1,454 @@
+#ifndef ROUND_ROBIN_DEFICIT_STORAGE_HPP
+#define ROUND_ROBIN_DEFICIT_STORAGE_HPP
+
+#include <algorithm> // For std::min
+#include <cstddef>
+#include <cstdint>
+#include <memory> // For std::allocator, std::allocator_traits
+#include <type_traits> // For std::is_same_v
+#include <utility> // For std::move, std::swap, std::in_place
+
+#include "round_robin/handle.hpp"
+#include "round_robin/vector_storage.hpp"
+
+namespace rr {
+
+/**
+ * @brief Deficit round-robin storage policy for RoundRobin.
+ *
+ * For items whose work varies in cost, such as flows of packets of different
+ * sizes, where plain rotation is fair per selection but not per byte. Each
+ * item has a quantum and a deficit counter. When the rotation reaches an item
+ * its quantum is added to its deficit, and try_next() keeps returning that
+ * item while the deficit is positive. The caller reports what it served with
+ * RoundRobin::charge_current() (or charge() through a handle), which subtracts
+ * the cost. Over time every busy item is served in proportion to its quantum,
+ * measured in whatever unit the costs are given in.
+ *
+ * The deficit may go negative, so the cost of a request does not need to be
+ * known before it is served. An item in debt is skipped, earning one quantum
+ * per pass, until it is back in credit. With a quantum at least as large as
+ * the largest cost, every item in the rotation is served at least once per pass.
+ * Costs above INT64_MAX count as INT64_MAX, and debt stops growing there.
+ * try_next() without charging keeps returning the same item.
+ *
+ * Items with no backlog leave the rotation with suspend_current() or
+ * suspend() and come back with resume() when work arrives, both in O(1), so
+ * a scheduler with many mostly idle flows only ever visits the busy ones. A
+ * suspended item loses any unused credit but keeps its debt.
+ *
+ * Items are kept as in VectorStorage, with the same insertion order, cycle
+ * guarantees and pointer validity rules.
+ *
+ * @tparam T The type of items stored.
+ * @tparam Allocator Allocator for T, rebound for the item buffer.
+ */
+template<typename T, typename Allocator = std::allocator<T>>
+class DeficitStorage {
+private:
+    /**
+     * @struct Flow
+     * @brief An item with its quantum and deficit counter.
+     */
+    struct Flow {
+        T value; ///< The actual item stored.
+        int64_t deficit = 0; ///< Credit left in the current turn; negative while in debt.
+        unsigned quantum; ///< Credit added each time the rotation reaches the item.
+
+        /**
+         * @brief Constructor for Flow, constructing the item in place.
+         * @param q The item's quantum.
+         * @param args Arguments forwarded to the constructor of T.
+         */
+        template<typename... Args>
+        Flow(unsigned q, std::in_place_t, Args&&... args) : value(std::forward<Args>(args)...), quantum(q) {}
+    };
+
+    using FlowAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Flow>;
+
+    VectorStorage<Flow, FlowAllocator> flows_; ///< The items, their rotation and their handles.
+
+    static constexpr int64_t max_debt = INT64_MAX; ///< Debt is clamped here, so deficits never overflow.
+
+    /**
+     * @brief Subtracts a cost from a deficit, saturating at max_debt.
+     */
+    static void debit(Flow& flow, uint64_t cost) {
+        const int64_t amount = static_cast<int64_t>(std::min<uint64_t>(cost, max_debt));
+        flow.deficit = flow.deficit < amount - max_debt ? -max_debt : flow.deficit - amount;
+    }
+
+    /**
+     * @brief Drops unused credit of an item leaving the rotation; debt is kept.
+     */
+    static void forfeit_credit(Flow& flow) {
+        flow.deficit = std::min<int64_t>(flow.deficit, 0);
+    }
+
+public:
+    /**
+     * @brief Constructor, initializing empty storage.
+     * @param alloc Allocator used for the item buffer.
+     */
+    explicit DeficitStorage(const Allocator& alloc = Allocator())
+        : flows_(FlowAllocator(alloc)) {}
+
+    DeficitStorage(DeficitStorage&&) noexcept = default;
+    DeficitStorage& operator=(DeficitStorage&&) noexcept = default;
+
+    DeficitStorage(const DeficitStorage&) = delete;
+    DeficitStorage& operator=(const DeficitStorage&) = delete;
+
+    /**
+     * @brief Exchanges the items and rotation state of two storages in O(1).
+     * @param other The storage to swap with.
+     */
+    void swap(DeficitStorage& other) noexcept {
+        flows_.swap(other.flows_);
+    }
+
+    /**
+     * @brief Adds an item with a quantum of 1.
+     * @param item The item to add, copied or moved into the storage.
+     * @return Handle to the new item.
+     */
+    template<typename U>
+    Handle add(U&& item) {
+        return add(std::forward<U>(item), 1u);
+    }
+
+    /**
+     * @brief Adds an item with the given quantum.
+     * @param item The item to add, copied or moved into the storage.
+     * @param quantum Credit the item receives per pass; must be at least 1.
+     * @return Handle to the new item.
+     */
+    template<typename U>
+    Handle add(U&& item, unsigned quantum) {
+        return flows_.add(Flow(quantum, std::in_place, std::forward<U>(item)));
+    }
+
+    /**
+     * @brief Constructs an item with a quantum of 1 in place.
+     * @param args Arguments forwarded to the constructor of T.
+     * @return Reference to the new item.
+     */
+    template<typename... Args>
+    T& emplace(Args&&... args) {
+        return flows_.emplace(1u, std::in_place, std::forward<Args>(args)...).value;
+    }
+
+    /**
+     * @brief Adds a range of items with a quantum of 1, keeping their order.
+     * @param first Iterator to the first item to add.
+     * @param last Iterator past the last item to add.
+     * @param on_add Called with the handle of each new item, in order.
+     */
+    template<typename InputIt, typename OnAdd = IgnoreHandles>
+    void add_range(InputIt first, InputIt last, OnAdd on_add = OnAdd()) {
+        for (; first != last; ++first) {
+            if constexpr (std::is_same_v<OnAdd, IgnoreHandles>) {
+                flows_.emplace(1u, std::in_place, *first);
+            } else {
+                on_add(flows_.add(Flow(1u, std::in_place, *first)));
+            }
+        }
+    }
+
+    /**
+     * @brief Reserves buffer space so the next n items are added without reallocating.
+     * @param n Total number of items to make room for.
+     */
+    void reserve(size_t n) {
+        flows_.reserve(n);
+    }
+
+    /**
+     * @brief Returns the item whose turn it is.
+     * @return A pointer to the item, or nullptr if no item is active.
+     *
+     * The current item is returned again while it has credit left. Otherwise
+     * the rotation moves on, adding each item's quantum to its deficit, until
+     * it reaches an item in credit. If a whole pass leaves every item in debt,
+     * the passes needed before the first one is back in credit are granted to
+     * all items at once, so a selection takes at most three passes however
+     * deep the debt. Granted passes count as one in cycles().
+     */
+    T* try_next() {
+        if (flows_.has_current()) {
+            Flow& flow = flows_.current();
+            if (flow.deficit > 0) {
+                return &flow.value;
+            }
+        }
+        const size_t active = flows_.size();
+        int64_t skip = max_debt;
+        for (size_t i = 0; i < active; ++i) {
+            Flow* flow = flows_.try_next();
+            flow->deficit += flow->quantum;
+            if (flow->deficit > 0) {
+                return &flow->value;
+            }
+            skip = std::min<int64_t>(skip, -flow->deficit / flow->quantum);
+        }
+        if (active == 0) {
+            return nullptr;
+        }
+        // skip passes would pay no item out of debt; skip * quantum never exceeds any item's debt
+        if (skip > 0) {
+            flows_.for_each_next(active, [skip](Flow& flow) { flow.deficit += skip * flow.quantum; });
+        }
+        while (Flow* flow = flows_.try_next()) {
+            flow->deficit += flow->quantum;
+            if (flow->deficit > 0) {
+                return &flow->value;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Calls try_next() n times, calling fn on each item returned.
+     * @param n Number of selections.
+     * @param fn Called with a reference to each item.
+     * @return n, or 0 if no item is active.
+     *
+     * Without charges in between, this is the same item n times.
+     */
+    template<typename Fn>
+    size_t for_each_next(size_t n, Fn&& fn) {
+        for (size_t i = 0; i < n; ++i) {
+            T* item = try_next();
+            if (!item) {
+                return 0;
+            }
+            fn(*item);
+        }
+        return n;
+    }
+
+    /**
+     * @brief Subtracts the cost of serving the most recently returned item from its deficit.
+     * @param cost The cost, in the same unit as the quanta.
+     *
+     * Requires has_current().
+     */
+    void charge_current(uint64_t cost) {
+        debit(flows_.current(), cost);
+    }
+
+    /**
+     * @brief Subtracts a cost from the deficit of the item a handle refers to, in O(1).
+     * @param handle A handle returned by add().
+     * @param cost The cost, in the same unit as the quanta.
+     * @return True if the item was charged, false if the handle is stale.
+     */
+    bool charge(Handle handle, uint64_t cost) {
+        Flow* flow = flows_.find(handle);
+        if (!flow) {
+            return false;
+        }
+        debit(*flow, cost);
+        return true;
+    }
+
+    /**
+     * @brief Checks whether there is a current item that can be erased.
+     * @return True if the most recently returned item is still stored.
+     */
+    bool has_current() const {
+        return flows_.has_current();
+    }
+
+    /**
+     * @brief Erases the most recently returned item by swap-and-pop.
+     *
+     * Requires has_current().
+     */
+    void erase_current() {
+        flows_.erase_current();
+    }
+
+    /**
+     * @brief Takes the most recently returned item out of the rotation in O(1).
+     *
+     * Requires has_current(). Meant for an item whose backlog ran out.
+     */
+    void suspend_current() {
+        forfeit_credit(flows_.current());
+        flows_.suspend_current();
+    }
+
+    /**
+     * @brief Returns suspended items matching a predicate to the rotation.
+     * @param pred Called with a const reference to each suspended item.
+     * @return The number of items resumed.
+     */
+    template<typename Pred>
+    size_t resume_if(Pred pred) {
+        return flows_.resume_if([&pred](const Flow& flow) { return pred(flow.value); });
+    }
+
+    /**
+     * @brief Checks out the most recently returned item in O(1).
+     * @return The item's handle, for unlease().
+     *
+     * Requires has_current().
+     */
+    Handle lease_current() {
+        return flows_.lease_current();
+    }
+
+    /**
+     * @brief Returns a leased item to the rotation, in O(1).
+     * @param handle The handle returned by lease_current().
+     * @return True if the item was returned, false if the handle is stale or
+     *         the item is not leased.
+     */
+    bool unlease(Handle handle) {
+        return flows_.unlease(handle);
+    }
+
+    /**
+     * @brief Looks up the item a handle refers to, in O(1).
+     * @param handle A handle returned by add().
+     * @return A pointer to the item, or nullptr if the handle is stale.
+     */
+    T* find(Handle handle) {
+        Flow* flow = flows_.find(handle);
+        return flow ? &flow->value : nullptr;
+    }
+
+    /**
+     * @brief Looks up the item a handle refers to, read-only, in O(1).
+     */
+    const T* find(Handle handle) const {
+        const Flow* flow = flows_.find(handle);
+        return flow ? &flow->value : nullptr;
+    }
+
+    /**
+     * @brief Looks up an item by handle, only if it is in the rotation.
+     * @param handle A handle returned by add().
+     * @return A pointer to the item, or nullptr if the handle is stale or the
+     *         item is suspended or leased.
+     */
+    T* find_active(Handle handle) {
+        Flow* flow = flows_.find_active(handle);
+        return flow ? &flow->value : nullptr;
+    }
+
+    /**
+     * @brief Erases the item a handle refers to, in O(1).
+     * @param handle A handle returned by add().
+     * @return True if the item was erased, false if the handle is stale.
+     */
+    bool erase(Handle handle) {
+        return flows_.erase(handle);
+    }
+
+    /**
+     * @brief Takes the item a handle refers to out of the rotation, in O(1).
+     * @param handle A handle returned by add().
+     * @return True if the item was suspended, false if the handle is stale or
+     *         the item is not in the rotation.
+     */
+    bool suspend(Handle handle) {
+        if (!flows_.suspend(handle)) {
+            return false;
+        }
+        forfeit_credit(*flows_.find(handle));
+        return true;
+    }
+
+    /**
+     * @brief Returns the item a handle refers to to the rotation, in O(1).
+     * @param handle A handle returned by add().
+     * @return True if the item was resumed, false if the handle is stale or
+     *         the item is not suspended.
+     */
+    bool resume(Handle handle) {
+        return flows_.resume(handle);
+    }
+
+    /**
+     * @brief Returns the quantum of the most recently returned item.
+     *
+     * Requires has_current().
+     */
+    unsigned current_weight() {
+        return flows_.current().quantum;
+    }
+
+    /**
+     * @brief Changes the quantum of the most recently returned item.
+     * @param quantum The new quantum; must be at least 1.
+     *
+     * Requires has_current(). Takes effect from the item's next turn.
+     */
+    void set_current_weight(unsigned quantum) {
+        flows_.current().quantum = quantum;
+    }
+
+    /**
+     * @brief Changes the quantum of the item a handle refers to, in O(1).
+     * @param handle A handle returned by add().
+     * @param quantum The new quantum; must be at least 1.
+     * @return True if the quantum was changed, false if the handle is stale.
+     *
+     * Takes effect from the item's next turn, including for suspended and
+     * leased items once they return. The deficit is left as it is.
+     */
+    bool set_weight(Handle handle, unsigned quantum) {
+        Flow* flow = flows_.find(handle);
+        if (!flow) {
+            return false;
+        }
+        flow->quantum = quantum;
+        return true;
+    }
+
+    /**
+     * @brief Returns the handle slot of the most recently returned item.
+     *
+     * Requires has_current().
+     */
+    uint32_t current_slot() const {
+        return flows_.current_slot();
+    }
+
+    /**
+     * @brief Returns how many passes the rotation has completed.
+     */
+    uint64_t cycles() const {
+        return flows_.cycles();
+    }
+
+    /**
+     * @brief Retrieves the number of items in the rotation.
+     * @return The count of active items.
+     */
+    size_t size() const {
+        return flows_.size();
+    }
+
+    /**
+     * @brief Retrieves the number of suspended items.
+     * @return The count of items held out of the rotation.
+     */
+    size_t suspended_count() const {
+        return flows_.suspended_count();
+    }
+
+    /**
+     * @brief Retrieves the number of leased items.
+     * @return The count of items checked out by lease_current().
+     */
+    size_t leased_count() const {
+        return flows_.leased_count();
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_DEFICIT_STORAGE_HPP
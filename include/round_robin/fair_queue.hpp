@@ -0,0 +1,361 @@
+#ifndef ROUND_ROBIN_FAIR_QUEUE_HPP
+#define ROUND_ROBIN_FAIR_QUEUE_HPP
+
+#include <cstddef>
+#include <functional> // For std::hash, std::equal_to
+#include <memory> // For std::allocator, std::allocator_traits
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility> // For std::move, std::swap
+
+#include "round_robin/round_robin.hpp"
+
+namespace rr {
+
+/**
+ * @brief A FIFO ring buffer that keeps its capacity when drained.
+ *
+ * The capacity is a power of two and doubles when the buffer is full, so
+ * pushes are amortized O(1) and a buffer that has reached its working size
+ * never allocates again.
+ *
+ * @tparam T The type of elements stored; must be move constructible.
+ * @tparam Allocator Allocator for the element buffer.
+ */
+template<typename T, typename Allocator = std::allocator<T>>
+class RingBuffer {
+private:
+    using Traits = std::allocator_traits<Allocator>;
+
+    static constexpr size_t initial_capacity = 8; ///< Capacity of the first buffer allocated.
+
+    Allocator alloc_; ///< Allocator for slots_.
+    T* slots_ = nullptr; ///< Element storage; only [head_, head_ + size_) modulo capacity_ is constructed.
+    size_t capacity_ = 0; ///< Number of slots, zero or a power of two.
+    size_t head_ = 0; ///< Index of the oldest element.
+    size_t size_ = 0; ///< Number of elements stored.
+
+    void grow() {
+        size_t capacity = capacity_ ? capacity_ * 2 : initial_capacity;
+        T* slots = Traits::allocate(alloc_, capacity);
+        for (size_t i = 0; i < size_; ++i) {
+            T& old = slots_[(head_ + i) & (capacity_ - 1)];
+            Traits::construct(alloc_, slots + i, std::move(old));
+            Traits::destroy(alloc_, &old);
+        }
+        if (slots_) {
+            Traits::deallocate(alloc_, slots_, capacity_);
+        }
+        slots_ = slots;
+        capacity_ = capacity;
+        head_ = 0;
+    }
+
+    void release() {
+        while (size_ != 0) {
+            pop_front();
+        }
+        if (slots_) {
+            Traits::deallocate(alloc_, slots_, capacity_);
+            slots_ = nullptr;
+            capacity_ = 0;
+        }
+    }
+
+public:
+    /**
+     * @brief Constructor, initializing an empty buffer without allocating.
+     * @param alloc Allocator used for the element buffer.
+     */
+    explicit RingBuffer(const Allocator& alloc = Allocator()) : alloc_(alloc) {}
+
+    /**
+     * @brief Move constructor, taking over other's buffer.
+     * @param other The buffer to move from; left empty, without a buffer.
+     */
+    RingBuffer(RingBuffer&& other) noexcept
+        : alloc_(other.alloc_)
+        , slots_(other.slots_)
+        , capacity_(other.capacity_)
+        , head_(other.head_)
+        , size_(other.size_) {
+        other.slots_ = nullptr;
+        other.capacity_ = 0;
+        other.head_ = 0;
+        other.size_ = 0;
+    }
+
+    /**
+     * @brief Move assignment operator, taking over other's buffer.
+     * @param other The buffer to move from; left empty, without a buffer.
+     * @return Reference to this buffer after the move.
+     */
+    RingBuffer& operator=(RingBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            alloc_ = other.alloc_;
+            std::swap(slots_, other.slots_);
+            std::swap(capacity_, other.capacity_);
+            std::swap(head_, other.head_);
+            std::swap(size_, other.size_);
+        }
+        return *this;
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    /**
+     * @brief Destructor, destroying the elements and freeing the buffer.
+     */
+    ~RingBuffer() {
+        release();
+    }
+
+    /**
+     * @brief Appends an element, constructed in place.
+     * @param args Arguments forwarded to the constructor of T.
+     */
+    template<typename... Args>
+    void emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            grow();
+        }
+        Traits::construct(alloc_, slots_ + ((head_ + size_) & (capacity_ - 1)), std::forward<Args>(args)...);
+        ++size_;
+    }
+
+    /**
+     * @brief Removes the oldest element and returns it. Requires !empty().
+     */
+    T pop_front() {
+        T& front = slots_[head_];
+        T value(std::move(front));
+        Traits::destroy(alloc_, &front);
+        head_ = (head_ + 1) & (capacity_ - 1);
+        --size_;
+        return value;
+    }
+
+    /**
+     * @brief Checks if the buffer is empty.
+     */
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Retrieves the number of elements stored.
+     */
+    size_t size() const {
+        return size_;
+    }
+
+    /**
+     * @brief Retrieves the number of elements that fit without allocating.
+     */
+    size_t capacity() const {
+        return capacity_;
+    }
+};
+
+/**
+ * @brief A fair scheduler over per-key FIFO queues.
+ *
+ * push() appends a task to the queue of its key (a tenant, a connection, a
+ * priority class) and pop() takes the oldest task of the next key in
+ * round-robin order, so every key with work gets one task per round no matter
+ * how many tasks it has queued.
+ *
+ * Each key's tasks live in a RingBuffer, and the keys sit in a
+ * RoundRobin<..., VectorStorage>. A key whose queue runs empty is suspended
+ * rather than removed, and resumed when it gets work again, so only keys with
+ * work are in the rotation while the queue and its buffer are kept for reuse.
+ * Once every key has been seen and every buffer has grown to its working size,
+ * push() and pop() are O(1) and do not allocate.
+ *
+ * Not thread-safe; like RoundRobin it is meant to be owned by one thread or
+ * guarded externally.
+ *
+ * @tparam Key The key tasks are grouped by.
+ * @tparam Task The type of tasks; must be move constructible.
+ * @tparam Hash Hash function for keys.
+ * @tparam KeyEqual Equality for keys.
+ * @tparam Allocator Allocator for tasks, rebound for the key index and queues.
+ */
+template<typename Key,
+         typename Task,
+         typename Hash = std::hash<Key>,
+         typename KeyEqual = std::equal_to<Key>,
+         typename Allocator = std::allocator<Task>>
+class FairQueue {
+private:
+    /**
+     * @struct Lane
+     * @brief The queue of one key.
+     */
+    struct Lane {
+        Key key; ///< The key this queue belongs to.
+        RingBuffer<Task, Allocator> tasks; ///< Queued tasks, oldest first.
+
+        Lane(const Key& k, const Allocator& alloc) : key(k), tasks(alloc) {}
+    };
+
+    using LaneAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Lane>;
+    using IndexAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const Key, Handle>>;
+
+    Allocator alloc_; ///< Allocator for the task buffers.
+    RoundRobin<Lane, VectorStorage, LaneAllocator> lanes_; ///< One lane per key; lanes without tasks are suspended.
+    std::unordered_map<Key, Handle, Hash, KeyEqual, IndexAllocator> index_; ///< Maps each key to its lane.
+    size_t size_ = 0; ///< Number of tasks queued over all keys.
+
+    /**
+     * @brief Returns the lane of a key, creating it (suspended) on first use.
+     */
+    Handle lane_of(const Key& key) {
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            return it->second;
+        }
+        Handle handle = lanes_.add(Lane(key, alloc_));
+        lanes_.suspend(handle);
+        index_.emplace(key, handle);
+        return handle;
+    }
+
+public:
+    /**
+     * @brief Constructor, initializing an empty queue.
+     * @param alloc Allocator used for tasks, the key index and the queues.
+     */
+    explicit FairQueue(const Allocator& alloc = Allocator())
+        : alloc_(alloc)
+        , lanes_(LaneAllocator(alloc))
+        , index_(0, Hash(), KeyEqual(), IndexAllocator(alloc)) {}
+
+    /**
+     * @brief Enqueues a copyable task for a key.
+     * @param key The key the task belongs to.
+     * @param task The task, copied into the queue.
+     */
+    void push(const Key& key, const Task& task) {
+        emplace(key, task);
+    }
+
+    /**
+     * @brief Enqueues a movable task for a key.
+     * @param key The key the task belongs to.
+     * @param task The task, moved into the queue.
+     */
+    void push(const Key& key, Task&& task) {
+        emplace(key, std::move(task));
+    }
+
+    /**
+     * @brief Constructs a task in place at the back of a key's queue.
+     * @param key The key the task belongs to.
+     * @param args Arguments forwarded to the constructor of Task.
+     *
+     * A key that had no work joins the rotation and is served before the
+     * current round ends.
+     */
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        Handle handle = lane_of(key);
+        Lane* lane = lanes_.get(handle);
+        bool was_idle = lane->tasks.empty();
+        lane->tasks.emplace_back(std::forward<Args>(args)...);
+        ++size_;
+        if (was_idle) {
+            lanes_.resume(handle);
+        }
+    }
+
+    /**
+     * @brief Dequeues the oldest task of the next key with work.
+     * @return The task, or std::nullopt if no task is queued.
+     */
+    std::optional<Task> try_pop() {
+        Lane* lane = lanes_.try_next();
+        if (!lane) {
+            return std::nullopt;
+        }
+        std::optional<Task> task(lane->tasks.pop_front());
+        --size_;
+        if (lane->tasks.empty()) {
+            lanes_.suspend_current();
+        }
+        return task;
+    }
+
+    /**
+     * @brief Dequeues the oldest task of the next key with work, throwing if none is queued.
+     * @return The task.
+     */
+    Task pop() {
+        std::optional<Task> task = try_pop();
+        if (!task) {
+            throw std::runtime_error("Attempted to pop from empty FairQueue");
+        }
+        return std::move(*task);
+    }
+
+    /**
+     * @brief Drops a key together with its queued tasks and its buffer.
+     * @param key The key to drop.
+     * @return The number of tasks dropped.
+     */
+    size_t erase(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return 0;
+        }
+        size_t dropped = lanes_.get(it->second)->tasks.size();
+        lanes_.remove(it->second);
+        index_.erase(it);
+        size_ -= dropped;
+        return dropped;
+    }
+
+    /**
+     * @brief Retrieves the number of tasks queued for a key.
+     * @param key The key to look up.
+     */
+    size_t size(const Key& key) const {
+        auto it = index_.find(key);
+        return it == index_.end() ? 0 : lanes_.get(it->second)->tasks.size();
+    }
+
+    /**
+     * @brief Checks if no task is queued.
+     */
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Retrieves the number of tasks queued over all keys.
+     */
+    size_t size() const {
+        return size_;
+    }
+
+    /**
+     * @brief Retrieves the number of keys with queued tasks.
+     */
+    size_t active_keys() const {
+        return lanes_.size();
+    }
+
+    /**
+     * @brief Retrieves the number of keys known, with or without queued tasks.
+     */
+    size_t key_count() const {
+        return index_.size();
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_FAIR_QUEUE_HPP
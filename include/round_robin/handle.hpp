@@ -0,0 +1,181 @@
+#ifndef ROUND_ROBIN_HANDLE_HPP
+#define ROUND_ROBIN_HANDLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory> // For std::allocator_traits
+#include <vector>
+#include <utility> // For std::move, std::swap
+
+namespace rr {
+
+/**
+ * @brief Lightweight reference to an item in a RoundRobin.
+ *
+ * Returned by add() and accepted by remove(), get(), suspend() and resume().
+ * A handle is a slot index plus the generation the slot had when the item was
+ * added. Removing the item bumps the generation, so a handle that outlives its
+ * item is recognised as stale instead of reaching whatever item reuses the
+ * slot. (Only after 2^32 reuses of the same slot could a stale handle match
+ * again.) A default-constructed handle never refers to an item.
+ */
+struct Handle {
+    uint32_t index = UINT32_MAX; ///< Slot in the container's slot table.
+    uint32_t generation = 0; ///< Generation of the slot when the item was added.
+
+    bool operator==(const Handle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const Handle& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @brief Default callback for the storages' add_range(); ignores the new handles.
+ */
+struct IgnoreHandles {
+    void operator()(Handle) const {}
+};
+
+/**
+ * @brief Maps handles to storage positions, shared by the storage policies.
+ *
+ * Each slot holds the current position of one item in its storage (an
+ * iterator or a buffer index). Storages that move items around update the
+ * slot with set(); lookups and releases are O(1). Released slots are reused
+ * through a free list, so the table never grows beyond the largest number of
+ * items stored at once.
+ *
+ * @tparam Position What the storage needs to find an item.
+ * @tparam Allocator Allocator rebound for the slot buffer.
+ */
+template<typename Position, typename Allocator>
+class SlotTable {
+private:
+    static constexpr uint32_t no_slot = UINT32_MAX;
+
+    /**
+     * @struct Slot
+     * @brief One entry of the table.
+     */
+    struct Slot {
+        Position position; ///< Where the item currently is; meaningless while free.
+        uint32_t generation; ///< Bumped every time the slot is released.
+        uint32_t next_free; ///< Next slot on the free list while free.
+    };
+
+    using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+
+    std::vector<Slot, SlotAllocator> slots_; ///< All slots, in use or free.
+    uint32_t free_head_ = no_slot; ///< First free slot, or no_slot.
+
+public:
+    /**
+     * @brief Constructor, initializing an empty table.
+     * @param alloc Allocator used for the slot buffer.
+     */
+    explicit SlotTable(const Allocator& alloc = Allocator())
+        : slots_(SlotAllocator(alloc)) {}
+
+    SlotTable(SlotTable&& other) noexcept
+        : slots_(std::move(other.slots_))
+        , free_head_(other.free_head_) {
+        other.clear();
+    }
+
+    SlotTable& operator=(SlotTable&& other) noexcept {
+        if (this != &other) {
+            slots_ = std::move(other.slots_);
+            free_head_ = other.free_head_;
+            other.clear();
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Takes a slot for a new item.
+     * @param position Where the item is stored.
+     * @return The handle of the new item.
+     */
+    Handle acquire(Position position) {
+        uint32_t index;
+        if (free_head_ != no_slot) {
+            index = free_head_;
+            free_head_ = slots_[index].next_free;
+            slots_[index].position = position;
+        } else {
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.push_back(Slot{position, 0, no_slot});
+        }
+        return Handle{index, slots_[index].generation};
+    }
+
+    /**
+     * @brief Frees the slot of an item that is being erased.
+     * @param index The slot index of the item.
+     */
+    void release(uint32_t index) {
+        Slot& slot = slots_[index];
+        ++slot.generation;
+        slot.next_free = free_head_;
+        free_head_ = index;
+    }
+
+    /**
+     * @brief Records that an item moved.
+     * @param index The slot index of the item.
+     * @param position Its new position.
+     */
+    void set(uint32_t index, Position position) {
+        slots_[index].position = position;
+    }
+
+    /**
+     * @brief Returns the current handle of a slot in use.
+     * @param index The slot index of the item.
+     */
+    Handle handle_of(uint32_t index) const {
+        return Handle{index, slots_[index].generation};
+    }
+
+    /**
+     * @brief Looks up the position of the item a handle refers to.
+     * @param handle The handle to check.
+     * @return A pointer to the position, or nullptr if the handle is stale.
+     */
+    const Position* find(Handle handle) const {
+        if (handle.index >= slots_.size() || slots_[handle.index].generation != handle.generation) {
+            return nullptr;
+        }
+        return &slots_[handle.index].position;
+    }
+
+    /**
+     * @brief Reserves room for n slots.
+     */
+    void reserve(size_t n) {
+        slots_.reserve(n);
+    }
+
+    /**
+     * @brief Exchanges the contents of two tables in O(1).
+     */
+    void swap(SlotTable& other) noexcept {
+        slots_.swap(other.slots_);
+        std::swap(free_head_, other.free_head_);
+    }
+
+    /**
+     * @brief Drops every slot, leaving a moved-from table empty.
+     */
+    void clear() {
+        slots_.clear();
+        free_head_ = no_slot;
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_HANDLE_HPP
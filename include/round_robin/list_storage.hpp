@@ -0,0 +1,517 @@
+#ifndef ROUND_ROBIN_LIST_STORAGE_HPP
+#define ROUND_ROBIN_LIST_STORAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory> // For std::allocator, std::allocator_traits
+#include <utility> // For std::move, std::swap, std::in_place
+#include <iterator> // For std::prev
+
+#include "round_robin/handle.hpp"
+
+namespace rr {
+
+/**
+ * @brief Linked-list storage policy for RoundRobin.
+ *
+ * Each item lives in its own list node, so the address of a stored item never
+ * changes while it is in the container. New items are inserted directly after
+ * the most recently returned item; items added before the first call to
+ * try_next() therefore come out in LIFO order.
+ *
+ * Suspended and leased items are spliced into separate lists, so they keep
+ * their node (and address) while out of the rotation and are never stepped
+ * over. Nodes are doubly linked so any item can be erased through its handle
+ * in O(1).
+ *
+ * @tparam T The type of items stored.
+ * @tparam Allocator Allocator for T, rebound to allocate list nodes.
+ */
+template<typename T, typename Allocator = std::allocator<T>>
+class ListStorage {
+private:
+    /**
+     * @struct Item
+     * @brief Internal struct to hold items in the rotation.
+     */
+    struct Item {
+        T value; ///< The actual item stored.
+        uint32_t slot = 0; ///< Index of this item's entry in the slot table.
+        bool suspended = false; ///< True while the node sits in the suspended list.
+        bool leased = false; ///< True while the node sits in the leased list.
+
+        /**
+         * @brief Constructor for Item, initializing with a movable item.
+         * @param v The item to store, moved into this struct.
+         */
+        Item(T&& v) : value(std::move(v)) {}
+
+        /**
+         * @brief Constructor for Item, initializing with a copyable item.
+         * @param v The item to store, copied into this struct.
+         */
+        Item(const T& v) : value(v) {}
+
+        /**
+         * @brief Constructor for Item, constructing the item in place.
+         * @param args Arguments forwarded to the constructor of T.
+         */
+        template<typename... Args>
+        explicit Item(std::in_place_t, Args&&... args) : value(std::forward<Args>(args)...) {}
+    };
+
+    using ItemAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Item>;
+    using iterator = typename std::list<Item, ItemAllocator>::iterator;
+
+    std::list<Item, ItemAllocator> items_; ///< The underlying container for round-robin scheduling.
+    std::list<Item, ItemAllocator> suspended_; ///< Items held out of the rotation.
+    std::list<Item, ItemAllocator> leased_; ///< Items checked out by lease_current().
+    SlotTable<iterator, Allocator> slots_; ///< Maps handles to list nodes.
+    iterator next_; ///< Item due next, or end() to wrap around; the rotation cursor.
+    bool current_valid_ = false; ///< True if the item before next_ is the one most recently returned.
+    uint64_t cycles_ = 0; ///< Number of times the cursor wrapped around.
+
+    /**
+     * @brief Points the cursor back at the start without a current item.
+     */
+    void reset_cursor() {
+        next_ = items_.begin();
+        current_valid_ = false;
+    }
+
+    /**
+     * @brief Registers a node just inserted before the cursor.
+     *
+     * New items go directly after the most recently returned item, so they are
+     * returned by the next call to try_next() and are part of the current cycle.
+     * Before any item has been returned they go to the front, which keeps the
+     * LIFO order of items added up front.
+     */
+    Handle link(iterator it) {
+        Handle handle = slots_.acquire(it);
+        it->slot = handle.index;
+        next_ = it;
+        return handle;
+    }
+
+    /**
+     * @brief Moves the cursor off an active item that is about to leave the rotation.
+     *
+     * Items are never reordered, so the rotation continues with the item that
+     * followed it and the current cycle still visits every other item once.
+     */
+    void detach(iterator it) {
+        if (current_valid_ && std::prev(next_) == it) {
+            current_valid_ = false;
+        }
+        if (next_ == it) {
+            ++next_;
+        }
+    }
+
+    void erase(iterator it) {
+        slots_.release(it->slot);
+        if (it->suspended) {
+            suspended_.erase(it);
+            return;
+        }
+        if (it->leased) {
+            leased_.erase(it);
+            return;
+        }
+        detach(it);
+        items_.erase(it);
+        if (items_.empty()) {
+            reset_cursor();
+        }
+    }
+
+    void suspend(iterator it) {
+        detach(it);
+        suspended_.splice(suspended_.begin(), items_, it);
+        it->suspended = true;
+        if (items_.empty()) {
+            reset_cursor();
+        }
+    }
+
+    void resume(iterator it) {
+        items_.splice(next_, suspended_, it);
+        it->suspended = false;
+        next_ = it;
+    }
+
+    void unlease(iterator it) {
+        items_.splice(next_, leased_, it);
+        it->leased = false;
+        next_ = it;
+    }
+
+public:
+    /**
+     * @brief Constructor, initializing empty storage.
+     * @param alloc Allocator used for the list nodes.
+     */
+    explicit ListStorage(const Allocator& alloc = Allocator())
+        : items_(ItemAllocator(alloc))
+        , suspended_(ItemAllocator(alloc))
+        , leased_(ItemAllocator(alloc))
+        , slots_(alloc)
+        , next_(items_.begin()) {}
+
+    /**
+     * @brief Move constructor, in O(1). The rotation continues where other left off.
+     * @param other The storage to move from; left empty.
+     */
+    ListStorage(ListStorage&& other) noexcept
+        : ListStorage(Allocator(other.items_.get_allocator())) {
+        swap(other);
+    }
+
+    /**
+     * @brief Move assignment operator. The rotation continues where other left off.
+     * @param other The storage to move from; left empty.
+     * @return Reference to this storage after the move.
+     *
+     * O(1) apart from destroying the items this storage held before.
+     */
+    ListStorage& operator=(ListStorage&& other) noexcept {
+        if (this != &other) {
+            ListStorage(std::move(other)).swap(*this);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Exchanges the items and rotation state of two storages in O(1).
+     * @param other The storage to swap with.
+     *
+     * List nodes are not moved, so handles and item addresses stay valid and
+     * follow their items. Only a cursor standing at end() has to be re-aimed,
+     * since end() belongs to the list object rather than to a node.
+     */
+    void swap(ListStorage& other) noexcept {
+        const bool wrapping = next_ == items_.end();
+        const bool other_wrapping = other.next_ == other.items_.end();
+        items_.swap(other.items_);
+        suspended_.swap(other.suspended_);
+        leased_.swap(other.leased_);
+        slots_.swap(other.slots_);
+        std::swap(next_, other.next_);
+        std::swap(current_valid_, other.current_valid_);
+        std::swap(cycles_, other.cycles_);
+        if (wrapping) {
+            other.next_ = other.items_.end();
+        }
+        if (other_wrapping) {
+            next_ = items_.end();
+        }
+    }
+
+    ListStorage(const ListStorage&) = delete;
+    ListStorage& operator=(const ListStorage&) = delete;
+
+    /**
+     * @brief Adds an item so that it is returned by the next call to try_next().
+     * @param item The item to add, copied or moved into the storage.
+     * @return Handle to the new item.
+     */
+    template<typename U>
+    Handle add(U&& item) {
+        return link(items_.emplace(next_, std::forward<U>(item)));
+    }
+
+    /**
+     * @brief Constructs an item in place, inside its list node.
+     * @param args Arguments forwarded to the constructor of T.
+     * @return Reference to the new item.
+     */
+    template<typename... Args>
+    T& emplace(Args&&... args) {
+        auto it = items_.emplace(next_, std::in_place, std::forward<Args>(args)...);
+        link(it);
+        return it->value;
+    }
+
+    /**
+     * @brief Inserts a range of items in one pass, keeping their order.
+     * @param first Iterator to the first item to add.
+     * @param last Iterator past the last item to add.
+     * @param on_add Called with the handle of each new item, in order.
+     *
+     * The items are inserted where add() would put a single item, so they
+     * are returned next, in the order given.
+     */
+    template<typename InputIt, typename OnAdd = IgnoreHandles>
+    void add_range(InputIt first, InputIt last, OnAdd on_add = OnAdd()) {
+        if (first == last) {
+            return;
+        }
+        const iterator pos = next_;
+        iterator head = items_.emplace(pos, std::in_place, *first);
+        on_add(link(head));
+        for (++first; first != last; ++first) {
+            on_add(link(items_.emplace(pos, std::in_place, *first)));
+        }
+        next_ = head;
+    }
+
+    /**
+     * @brief Reserves handle slots; list nodes are allocated one at a time.
+     * @param n Total number of items to make room for.
+     */
+    void reserve(size_t n) {
+        slots_.reserve(n);
+    }
+
+    /**
+     * @brief Advances the cursor and returns the item it lands on.
+     * @return A pointer to the next item, or nullptr if the storage is empty.
+     */
+    T* try_next() {
+        if (items_.empty()) {
+            reset_cursor();
+            return nullptr;
+        }
+
+        if (next_ == items_.end()) {
+            next_ = items_.begin(); // Wrap around and start a new cycle
+            ++cycles_;
+        }
+
+        current_valid_ = true;
+        return &(next_++)->value;
+    }
+
+    /**
+     * @brief Advances the cursor n times, calling fn on each item it lands on.
+     * @param n Number of items to visit.
+     * @param fn Called with a reference to each item in rotation order.
+     * @return n, or 0 if the storage is empty.
+     */
+    template<typename Fn>
+    size_t for_each_next(size_t n, Fn&& fn) {
+        if (items_.empty()) {
+            reset_cursor();
+            return 0;
+        }
+        if (n == 0) {
+            return 0;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            if (next_ == items_.end()) {
+                next_ = items_.begin(); // Wrap around and start a new cycle
+                ++cycles_;
+            }
+            fn((next_++)->value);
+        }
+
+        current_valid_ = true;
+        return n;
+    }
+
+    /**
+     * @brief Checks whether there is a current item that can be erased.
+     * @return True if the most recently returned item is still stored.
+     */
+    bool has_current() const {
+        return current_valid_;
+    }
+
+    /**
+     * @brief Erases the most recently returned item.
+     *
+     * Requires has_current(). The rotation continues with the item that
+     * followed the erased one.
+     */
+    void erase_current() {
+        erase(std::prev(next_));
+    }
+
+    /**
+     * @brief Takes the most recently returned item out of the rotation in O(1).
+     *
+     * Requires has_current(). The node is spliced into the suspended list, so
+     * the item keeps its address. The rotation continues with the item that
+     * followed it.
+     */
+    void suspend_current() {
+        suspend(std::prev(next_));
+    }
+
+    /**
+     * @brief Checks out the most recently returned item in O(1).
+     * @return The item's handle, for unlease().
+     *
+     * Requires has_current(). The node is spliced into the leased list, so
+     * the item keeps its address and is skipped by the rotation, resume_if()
+     * and resume() until it is returned with unlease().
+     */
+    Handle lease_current() {
+        iterator it = std::prev(next_);
+        detach(it);
+        leased_.splice(leased_.begin(), items_, it);
+        it->leased = true;
+        if (items_.empty()) {
+            reset_cursor();
+        }
+        return slots_.handle_of(it->slot);
+    }
+
+    /**
+     * @brief Returns a leased item to the rotation, in O(1).
+     * @param handle The handle returned by lease_current().
+     * @return True if the item was returned, false if the handle is stale or
+     *         the item is not leased.
+     *
+     * The item is spliced in where add() would put it, so it is returned next.
+     */
+    bool unlease(Handle handle) {
+        const iterator* pos = slots_.find(handle);
+        if (!pos || !(*pos)->leased) {
+            return false;
+        }
+        unlease(*pos);
+        return true;
+    }
+
+    /**
+     * @brief Returns suspended items matching a predicate to the rotation.
+     * @param pred Called with a const reference to each suspended item.
+     * @return The number of items resumed.
+     *
+     * Only suspended items are examined. Resumed items are spliced in where
+     * add() would put them, so they are returned next.
+     */
+    template<typename Pred>
+    size_t resume_if(Pred pred) {
+        size_t resumed = 0;
+        for (auto it = suspended_.begin(); it != suspended_.end();) {
+            auto candidate = it++;
+            if (pred(static_cast<const T&>(candidate->value))) {
+                resume(candidate);
+                ++resumed;
+            }
+        }
+        return resumed;
+    }
+
+    /**
+     * @brief Looks up the item a handle refers to, in O(1).
+     * @param handle A handle returned by add().
+     * @return A pointer to the item, or nullptr if the handle is stale.
+     */
+    T* find(Handle handle) {
+        const iterator* pos = slots_.find(handle);
+        return pos ? &(*pos)->value : nullptr;
+    }
+
+    /**
+     * @brief Looks up the item a handle refers to, read-only, in O(1).
+     */
+    const T* find(Handle handle) const {
+        const iterator* pos = slots_.find(handle);
+        return pos ? &(*pos)->value : nullptr;
+    }
+
+    /**
+     * @brief Looks up an item by handle, only if it is in the rotation.
+     * @param handle A handle returned by add().
+     * @return A pointer to the item, or nullptr if the handle is stale or the
+     *         item is suspended or leased.
+     */
+    T* find_active(Handle handle) {
+        const iterator* pos = slots_.find(handle);
+        return pos && !(*pos)->suspended && !(*pos)->leased ? &(*pos)->value : nullptr;
+    }
+
+    /**
+     * @brief Erases the item a handle refers to, in O(1).
+     * @param handle A handle returned by add().
+     * @return True if the item was erased, false if the handle is stale.
+     */
+    bool erase(Handle handle) {
+        const iterator* pos = slots_.find(handle);
+        if (!pos) {
+            return false;
+        }
+        erase(*pos);
+        return true;
+    }
+
+    /**
+     * @brief Takes the item a handle refers to out of the rotation, in O(1).
+     * @param handle A handle returned by add().
+     * @return True if the item was suspended, false if the handle is stale or
+     *         the item is already suspended.
+     */
+    bool suspend(Handle handle) {
+        const iterator* pos = slots_.find(handle);
+        if (!pos || (*pos)->suspended || (*pos)->leased) {
+            return false;
+        }
+        suspend(*pos);
+        return true;
+    }
+
+    /**
+     * @brief Returns the item a handle refers to to the rotation, in O(1).
+     * @param handle A handle returned by add().
+     * @return True if the item was resumed, false if the handle is stale or
+     *         the item is not suspended.
+     */
+    bool resume(Handle handle) {
+        const iterator* pos = slots_.find(handle);
+        if (!pos || !(*pos)->suspended) {
+            return false;
+        }
+        resume(*pos);
+        return true;
+    }
+
+    /**
+     * @brief Returns the handle slot of the most recently returned item.
+     *
+     * Requires has_current().
+     */
+    uint32_t current_slot() const {
+        return std::prev(next_)->slot;
+    }
+
+    /**
+     * @brief Returns how many times the cursor has wrapped around to start a new cycle.
+     */
+    uint64_t cycles() const {
+        return cycles_;
+    }
+
+    /**
+     * @brief Retrieves the number of items in the rotation.
+     * @return The count of active items.
+     */
+    size_t size() const {
+        return items_.size();
+    }
+
+    /**
+     * @brief Retrieves the number of suspended items.
+     * @return The count of items held out of the rotation.
+     */
+    size_t suspended_count() const {
+        return suspended_.size();
+    }
+
+    /**
+     * @brief Retrieves the number of leased items.
+     * @return The count of items checked out by lease_current().
+     */
+    size_t leased_count() const {
+        return leased_.size();
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_LIST_STORAGE_HPP
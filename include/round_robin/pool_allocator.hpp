@@ -0,0 +1,238 @@
+#ifndef ROUND_ROBIN_POOL_ALLOCATOR_HPP
+#define ROUND_ROBIN_POOL_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility> // For std::move
+#include <vector>
+
+namespace rr {
+
+/**
+ * @brief Fixed-size block pool shared by all copies of a PoolAllocator.
+ *
+ * Blocks are carved out of larger chunks and recycled through a free list, so
+ * once a container has reached its working size, adding and removing items
+ * no longer calls into the global allocator. There is one free list per block
+ * size, which covers the node types a container rebinds its allocator to.
+ *
+ * Chunks are only returned to the system when the resource is destroyed,
+ * which happens when the last PoolAllocator referring to it goes away.
+ *
+ * A resource is not synchronized. Give each container its own allocator (the
+ * default), so threads working on different containers never contend.
+ */
+class PoolResource {
+private:
+    /**
+     * @struct FreeBlock
+     * @brief Link stored inside a block while it sits on the free list.
+     */
+    struct FreeBlock {
+        FreeBlock* next; ///< Next free block of the same size.
+    };
+
+    /**
+     * @struct Pool
+     * @brief Free list and chunk bookkeeping for one block size.
+     */
+    struct Pool {
+        size_t block_size; ///< Size of every block in this pool.
+        FreeBlock* free_list = nullptr; ///< Blocks ready for reuse.
+        size_t next_chunk_blocks = 32; ///< Blocks in the next chunk; doubles up to max_chunk_blocks.
+        size_t blocks_in_use = 0; ///< Blocks handed out and not yet returned.
+    };
+
+    static constexpr size_t max_chunk_blocks = 4096; ///< Upper bound on blocks per chunk.
+    static constexpr size_t block_align = alignof(std::max_align_t); ///< Alignment of every block.
+
+    std::vector<Pool> pools_; ///< One pool per block size, searched linearly (there are few).
+    std::vector<void*> chunks_; ///< Every chunk obtained from the system.
+    size_t bytes_reserved_ = 0; ///< Total size of all chunks.
+
+    static size_t round_up(size_t bytes) {
+        if (bytes < sizeof(FreeBlock)) {
+            bytes = sizeof(FreeBlock);
+        }
+        return (bytes + block_align - 1) / block_align * block_align;
+    }
+
+    Pool& pool_for(size_t block_size) {
+        for (auto& pool : pools_) {
+            if (pool.block_size == block_size) {
+                return pool;
+            }
+        }
+        pools_.push_back(Pool{block_size});
+        return pools_.back();
+    }
+
+    /**
+     * @brief Allocates a new chunk for a pool and threads it onto the free list.
+     */
+    void grow(Pool& pool) {
+        const size_t blocks = pool.next_chunk_blocks;
+        const size_t bytes = blocks * pool.block_size;
+        chunks_.reserve(chunks_.size() + 1);
+        char* chunk = static_cast<char*>(::operator new(bytes));
+        chunks_.push_back(chunk);
+        bytes_reserved_ += bytes;
+
+        for (size_t i = blocks; i-- > 0;) {
+            auto* block = reinterpret_cast<FreeBlock*>(chunk + i * pool.block_size);
+            block->next = pool.free_list;
+            pool.free_list = block;
+        }
+        if (pool.next_chunk_blocks < max_chunk_blocks) {
+            pool.next_chunk_blocks *= 2;
+        }
+    }
+
+public:
+    PoolResource() = default;
+
+    /**
+     * @brief Destructor, returning every chunk to the system.
+     */
+    ~PoolResource() {
+        for (void* chunk : chunks_) {
+            ::operator delete(chunk);
+        }
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    /**
+     * @brief Takes a block of at least the given size from the pool.
+     * @param bytes Requested size; alignment up to alignof(std::max_align_t) is guaranteed.
+     * @return Pointer to the block.
+     */
+    void* allocate(size_t bytes) {
+        Pool& pool = pool_for(round_up(bytes));
+        if (!pool.free_list) {
+            grow(pool);
+        }
+        FreeBlock* block = pool.free_list;
+        pool.free_list = block->next;
+        ++pool.blocks_in_use;
+        return block;
+    }
+
+    /**
+     * @brief Returns a block obtained from allocate() with the same size.
+     * @param p The block.
+     * @param bytes The size passed to allocate().
+     */
+    void deallocate(void* p, size_t bytes) {
+        Pool& pool = pool_for(round_up(bytes));
+        auto* block = static_cast<FreeBlock*>(p);
+        block->next = pool.free_list;
+        pool.free_list = block;
+        --pool.blocks_in_use;
+    }
+
+    /**
+     * @brief Returns the number of blocks currently handed out.
+     */
+    size_t blocks_in_use() const {
+        size_t total = 0;
+        for (const auto& pool : pools_) {
+            total += pool.blocks_in_use;
+        }
+        return total;
+    }
+
+    /**
+     * @brief Returns the number of bytes obtained from the system so far.
+     */
+    size_t bytes_reserved() const {
+        return bytes_reserved_;
+    }
+};
+
+/**
+ * @brief Allocator that serves single-object allocations from a PoolResource.
+ *
+ * Node-based containers allocate one node at a time, which is exactly what the
+ * pool recycles; larger array allocations (for example a std::vector buffer)
+ * go straight to the global allocator. Copies and rebound copies share the
+ * same resource, and the allocator follows its container on move, copy and
+ * swap, so memory always goes back to the pool it came from.
+ *
+ * @tparam T The type of objects allocated.
+ */
+template<typename T>
+class PoolAllocator {
+private:
+    std::shared_ptr<PoolResource> resource_; ///< The pool shared by all copies.
+
+    template<typename U>
+    friend class PoolAllocator;
+
+    static constexpr bool pooled = alignof(T) <= alignof(std::max_align_t);
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    /**
+     * @brief Constructs an allocator with a new, empty pool.
+     */
+    PoolAllocator() : resource_(std::make_shared<PoolResource>()) {}
+
+    /**
+     * @brief Constructs an allocator that uses an existing pool.
+     * @param resource The pool to share.
+     */
+    explicit PoolAllocator(std::shared_ptr<PoolResource> resource)
+        : resource_(std::move(resource)) {}
+
+    /**
+     * @brief Rebinding constructor; the result shares the same pool.
+     * @param other The allocator to share the pool of.
+     */
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : resource_(other.resource_) {}
+
+    T* allocate(size_t n) {
+        if (n == 1 && pooled) {
+            return static_cast<T*>(resource_->allocate(sizeof(T)));
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (n == 1 && pooled) {
+            resource_->deallocate(p, sizeof(T));
+        } else {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    /**
+     * @brief Returns the pool this allocator draws from.
+     */
+    const PoolResource& resource() const {
+        return *resource_;
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return resource_ == other.resource_;
+    }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept {
+        return resource_ != other.resource_;
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_POOL_ALLOCATOR_HPP
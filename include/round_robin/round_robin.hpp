@@ -1,98 +1,250 @@
 #ifndef ROUND_ROBIN_HPP
 #define ROUND_ROBIN_HPP
 
-#include <forward_list>
+#include <chrono>
+#include <cstdint>
+#include <memory> // For std::allocator
 #include <stdexcept>
-#include <utility> // For std::move
-#include <cassert> // For assert (used in debug checks)
+#include <type_traits> // For std::enable_if_t, std::is_nothrow_move_constructible_v
+#include <utility> // For std::move, std::swap
+
+#include "round_robin/affinity.hpp"
+#include "round_robin/deficit_storage.hpp"
+#include "round_robin/handle.hpp"
+#include "round_robin/list_storage.hpp"
+#include "round_robin/pool_allocator.hpp"
+#include "round_robin/stats.hpp"
+#include "round_robin/trace.hpp"
+#include "round_robin/vector_storage.hpp"
+#include "round_robin/weighted_storage.hpp"
 
 namespace rr {
 
 /**
  * @brief A round-robin container that cycles through items in a consistent order.
- * 
+ *
  * This class is designed to provide a round-robin scheduling strategy, where each item
  * added to the container is visited in a cyclic manner. It supports movable and copyable
  * types, with special handling for move-only types like std::unique_ptr.
- * 
+ *
+ * How items are laid out in memory is decided by the storage policy. The default
+ * ListStorage keeps every item at a stable address; VectorStorage keeps items in
+ * one contiguous buffer for the fastest rotation over small values; WeightedStorage
+ * selects items in proportion to a per-item weight; DeficitStorage serves items
+ * in proportion to a per-item quantum of reported cost (deficit round-robin).
+ *
+ * The allocator is passed through to the storage's underlying containers. For
+ * workloads that add and remove items constantly, PoolAllocator (see
+ * PooledRoundRobin) recycles list nodes instead of calling malloc and free.
+ *
+ * Instrumentation is opt-in through the Stats policy. The default NoStats
+ * compiles every hook out; SelectionStats counts selections per item, cycles
+ * and removals, and TimedSelectionStats adds a selection-time histogram. See
+ * stats(). TraceRecorder instead records every add, selection and removal
+ * for replay with the rr_replay tool.
+ *
+ * Sticky lookups are opt-in through the Affinity policy. With KeyAffinity,
+ * next_for_key() maps a key hash to the same item every time by consistent
+ * hashing over the items in the container, kept up to date by add() and
+ * remove(), while next() keeps rotating.
+ *
+ * Not thread-safe: a RoundRobin shared between threads must be guarded by
+ * the caller's own lock, held while using the item try_next() returns.
+ * ConcurrentRoundRobin and ShardedRoundRobin are the thread-safe alternatives.
+ *
  * @tparam T The type of items stored in the round-robin container.
+ * @tparam Storage The storage policy, ListStorage, VectorStorage, WeightedStorage or DeficitStorage.
+ * @tparam Allocator Allocator for T, rebound by the storage as needed.
+ * @tparam Stats The stats policy, NoStats, SelectionStats, TimedSelectionStats or TraceRecorder.
+ * @tparam Affinity The affinity policy, NoAffinity or KeyAffinity.
  */
-template<typename T>
+template<typename T,
+         template<typename, typename> class Storage = ListStorage,
+         typename Allocator = std::allocator<T>,
+         typename Stats = NoStats,
+         typename Affinity = NoAffinity>
 class RoundRobin {
 private:
-    /**
-     * @struct Item
-     * @brief Internal struct to hold items with a visited flag.
-     */
-    struct Item {
-        T value; ///< The actual item stored.
-        bool visited; ///< Flag to track if the item has been visited in the current cycle.
-        
-        /**
-         * @brief Constructor for Item, initializing with a movable item.
-         * @param v The item to store, moved into this struct.
-         */
-        Item(T&& v) : value(std::move(v)), visited(false) {}
-        
-        /**
-         * @brief Constructor for Item, initializing with a copyable item.
-         * @param v The item to store, copied into this struct.
-         */
-        Item(const T& v) : value(v), visited(false) {}
-    };
+    static constexpr unsigned affinity_probes = 8; ///< Items tried by next_for_key() before it falls back to rotating.
+    static constexpr bool reports_adds = Affinity::enabled || Stats::traced; ///< Whether added items' handles are needed.
 
-    std::forward_list<Item> items_; ///< The underlying container for round-robin scheduling.
-    typename std::forward_list<Item>::iterator current_; ///< Iterator to track the current item for potential removal.
-    size_t count_ = 0; ///< Count of items in the container.
+    Storage<T, Allocator> storage_; ///< The underlying storage and rotation cursor.
+    Stats stats_; ///< Counters; empty and unused with NoStats.
+    Affinity affinity_; ///< Key-to-item index; empty and unused with NoAffinity.
 
     /**
-     * @brief Checks if all items in the container have been visited.
-     * @return True if all items have been visited, false otherwise.
+     * @brief Reports a new item to the affinity and stats policies.
      */
-    bool all_visited() const {
-        for (const auto& item : items_) {
-            if (!item.visited) return false;
+    Handle record_add(Handle handle, unsigned weight = 1) {
+        if constexpr (Affinity::enabled) {
+            affinity_.on_add(handle);
         }
-        return true;
+        if constexpr (Stats::traced) {
+            stats_.on_add(handle.index, weight);
+        }
+        return handle;
     }
 
     /**
-     * @brief Resets the visited flags for all items in the container.
+     * @brief Reports the selection just made to the stats policy.
      */
-    void reset_visited() {
-        for (auto& item : items_) {
-            item.visited = false;
+    void record_select() {
+        if constexpr (Stats::enabled) {
+            stats_.on_select(storage_.current_slot(), storage_.cycles());
+        }
+    }
+
+    static void check_weight(unsigned weight) {
+        if (weight == 0) {
+            throw std::invalid_argument("RoundRobin item weight must be at least 1");
         }
     }
 
 public:
+    /**
+     * @class Lease
+     * @brief Exclusive checkout of one item; returns it to the rotation when destroyed.
+     *
+     * While a Lease is alive its item is out of the rotation, so next() never
+     * hands it to anyone else, and resume_if(), resume_all() and resume() leave
+     * it alone. The item is returned where add() would put a new one.
+     *
+     * A Lease refers to its container by address, so it must not outlive it or
+     * be kept across a move or swap of the container. The item may still be
+     * removed through its handle meanwhile; the Lease then returns nothing.
+     */
+    class Lease {
+    private:
+        RoundRobin* owner_ = nullptr; ///< The container the item is returned to, or nullptr if empty.
+        Handle handle_; ///< The leased item.
+
+        friend class RoundRobin;
+
+        Lease(RoundRobin* owner, Handle handle) : owner_(owner), handle_(handle) {}
+
+    public:
+        /**
+         * @brief Constructs an empty Lease.
+         */
+        Lease() = default;
+
+        /**
+         * @brief Move constructor, transferring the checkout.
+         * @param other The Lease to move from; left empty.
+         */
+        Lease(Lease&& other) noexcept : owner_(other.owner_), handle_(other.handle_) {
+            other.owner_ = nullptr;
+        }
+
+        /**
+         * @brief Move assignment operator, returning the current item first.
+         * @param other The Lease to move from; left empty.
+         * @return Reference to this Lease after the move.
+         */
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                reset();
+                owner_ = other.owner_;
+                handle_ = other.handle_;
+                other.owner_ = nullptr;
+            }
+            return *this;
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        /**
+         * @brief Destructor, returning the item to the rotation.
+         */
+        ~Lease() {
+            reset();
+        }
+
+        /**
+         * @brief Returns the item to the rotation early. The Lease becomes empty.
+         */
+        void reset() {
+            if (owner_) {
+                owner_->storage_.unlease(handle_);
+                owner_ = nullptr;
+            }
+        }
+
+        /**
+         * @brief Returns a pointer to the item, or nullptr if the Lease is empty
+         *        or the item has been removed.
+         *
+         * Looked up through the handle on every call, so it stays correct when
+         * VectorStorage or WeightedStorage move the item within their buffer.
+         */
+        T* get() const {
+            return owner_ ? owner_->storage_.find(handle_) : nullptr;
+        }
+
+        /**
+         * @brief Returns the handle of the leased item.
+         */
+        Handle handle() const {
+            return handle_;
+        }
+
+        /**
+         * @brief Checks whether the Lease holds an item.
+         */
+        explicit operator bool() const {
+            return owner_ != nullptr;
+        }
+
+        T& operator*() const {
+            return *get();
+        }
+
+        T* operator->() const {
+            return get();
+        }
+    };
+
     /**
      * @brief Default constructor, initializing an empty round-robin container.
      */
-    RoundRobin() : current_(items_.before_begin()) {}
+    RoundRobin() = default;
+
+    /**
+     * @brief Constructor, initializing an empty round-robin container with an allocator.
+     * @param alloc The allocator passed to the underlying storage.
+     */
+    explicit RoundRobin(const Allocator& alloc) : storage_(alloc) {}
 
     /**
      * @brief Move constructor, transferring ownership of the round-robin container.
-     * @param other The RoundRobin instance to move from.
+     * @param other The RoundRobin instance to move from; left empty.
+     *
+     * The rotation state moves with the items in O(1): the next call to
+     * try_next() returns the item other would have returned, the current item
+     * can still be removed, the remainder of the current cycle is unchanged,
+     * weights and scheduling state are kept, and handles stay valid. This
+     * makes it safe to hand a pool to another thread mid-cycle (with the
+     * usual synchronization for the handoff itself).
      */
-    RoundRobin(RoundRobin&& other) noexcept 
-        : items_(std::move(other.items_))
-       , current_(items_.before_begin())
-       , count_(other.count_) {
-        other.count_ = 0;
-    }
+    RoundRobin(RoundRobin&& other) noexcept(std::is_nothrow_move_constructible_v<Stats>)
+        : storage_(std::move(other.storage_))
+        , stats_(std::move(other.stats_))
+        , affinity_(std::move(other.affinity_)) {}
 
     /**
      * @brief Move assignment operator, transferring ownership of the round-robin container.
-     * @param other The RoundRobin instance to move from.
+     * @param other The RoundRobin instance to move from; left empty.
      * @return Reference to this RoundRobin instance after the move.
+     *
+     * Transfers the rotation state as the move constructor does. The items
+     * previously held are destroyed.
      */
-    RoundRobin& operator=(RoundRobin&& other) noexcept {
+    RoundRobin& operator=(RoundRobin&& other) noexcept(std::is_nothrow_move_assignable_v<Stats>) {
         if (this!= &other) {
-            items_ = std::move(other.items_);
-            current_ = items_.before_begin();
-            count_ = other.count_;
-            other.count_ = 0;
+            storage_ = std::move(other.storage_);
+            stats_ = std::move(other.stats_);
+            affinity_ = std::move(other.affinity_);
         }
         return *this;
     }
@@ -104,58 +256,199 @@ public:
     /**
      * @brief Adds a copyable item to the round-robin container.
      * @param item The item to add, copied into the container.
+     * @return Handle for get(), remove(), suspend() and resume().
      */
-    void add(const T& item) {
-        items_.push_front(Item(item));
-        ++count_;
+    Handle add(const T& item) {
+        return record_add(storage_.add(item));
     }
 
     /**
      * @brief Adds a movable item to the round-robin container.
      * @param item The item to add, moved into the container.
+     * @return Handle for get(), remove(), suspend() and resume().
+     */
+    Handle add(T&& item) {
+        return record_add(storage_.add(std::move(item)));
+    }
+
+    /**
+     * @brief Constructs an item in place inside the container.
+     * @param args Arguments forwarded to the constructor of T.
+     * @return Reference to the new item.
+     *
+     * No temporary T is created, so with ListStorage this also works for
+     * types that can be neither copied nor moved. The item is placed exactly
+     * where add() would place it. With KeyAffinity or TraceRecorder, which
+     * need the new item's handle, the item is constructed first and then
+     * moved in.
+     */
+    template<typename... Args>
+    T& emplace(Args&&... args) {
+        if constexpr (reports_adds) {
+            return *storage_.find(record_add(storage_.add(T(std::forward<Args>(args)...))));
+        } else {
+            return storage_.emplace(std::forward<Args>(args)...);
+        }
+    }
+
+    /**
+     * @brief Adds every item of a range in one pass, preserving the given order.
+     * @param first Iterator to the first item to add.
+     * @param last Iterator past the last item to add.
+     *
+     * Unlike a sequence of add() calls, which the default ListStorage returns
+     * in reverse (LIFO) order, the items are returned in the order of the
+     * range. Use std::make_move_iterator to move the items in.
+     */
+    template<typename InputIt>
+    void add_range(InputIt first, InputIt last) {
+        if constexpr (reports_adds) {
+            storage_.add_range(first, last, [this](Handle handle) { record_add(handle); });
+        } else {
+            storage_.add_range(first, last);
+        }
+    }
+
+    /**
+     * @brief Prepares the container to hold n items without reallocating.
+     * @param n Total number of items to make room for.
+     *
+     * Reserves buffer space for the contiguous storages; ListStorage allocates
+     * nodes one at a time and ignores it.
+     */
+    void reserve(size_t n) {
+        storage_.reserve(n);
+        if constexpr (Affinity::enabled) {
+            affinity_.reserve(n);
+        }
+    }
+
+    /**
+     * @brief Adds a copyable item with a weight. Requires WeightedStorage or DeficitStorage.
+     * @param item The item to add, copied into the container.
+     * @param weight Relative share of selections the item receives; for
+     *        DeficitStorage, its quantum.
+     * @return Handle for get(), remove(), suspend() and resume().
+     * @throws std::invalid_argument if weight is zero.
+     */
+    Handle add(const T& item, unsigned weight) {
+        check_weight(weight);
+        return record_add(storage_.add(item, weight), weight);
+    }
+
+    /**
+     * @brief Adds a movable item with a weight. Requires WeightedStorage or DeficitStorage.
+     * @param item The item to add, moved into the container.
+     * @param weight Relative share of selections the item receives; for
+     *        DeficitStorage, its quantum.
+     * @return Handle for get(), remove(), suspend() and resume().
+     * @throws std::invalid_argument if weight is zero.
+     */
+    Handle add(T&& item, unsigned weight) {
+        check_weight(weight);
+        return record_add(storage_.add(std::move(item), weight), weight);
+    }
+
+    /**
+     * @brief Changes the weight of the current item. Requires WeightedStorage or DeficitStorage.
+     * @param weight The new weight.
+     *
+     * Takes effect from the item's next selection; the rest of the rotation is
+     * not rebuilt.
+     *
+     * @throws std::invalid_argument if weight is zero.
+     * @throws std::runtime_error if there is no current item.
      */
-    void add(T&& item) {
-        items_.push_front(Item(std::move(item)));
-        ++count_;
+    void set_current_weight(unsigned weight) {
+        check_weight(weight);
+        if (!storage_.has_current()) {
+            throw std::runtime_error("Invalid current position in RoundRobin");
+        }
+        storage_.set_current_weight(weight);
+    }
+
+    /**
+     * @brief Changes the weight of an item, by its handle. Requires WeightedStorage or DeficitStorage.
+     * @param handle The item's handle.
+     * @param weight The new weight.
+     * @return True if the weight was changed, false if the handle is stale.
+     *
+     * For reweighting a given item, such as a backend whose capacity changed,
+     * without waiting for its turn. With WeightedStorage the item keeps its
+     * progress towards its next selection, rescaled to the new weight, in
+     * O(log n). Suspended and leased items keep the new weight for when they
+     * return.
+     *
+     * @throws std::invalid_argument if weight is zero.
+     */
+    bool set_weight(Handle handle, unsigned weight) {
+        check_weight(weight);
+        return storage_.set_weight(handle, weight);
+    }
+
+    /**
+     * @brief Reports the cost of the work just served from the current item. Requires DeficitStorage.
+     * @param cost The cost, in the same unit as the quanta (bytes, for example).
+     *
+     * Subtracted from the item's deficit; next() keeps returning the item
+     * while the deficit stays positive and moves on once it is used up.
+     *
+     * @throws std::runtime_error if there is no current item.
+     */
+    void charge_current(uint64_t cost) {
+        if (!storage_.has_current()) {
+            throw std::runtime_error("Invalid current position in RoundRobin");
+        }
+        storage_.charge_current(cost);
+    }
+
+    /**
+     * @brief Reports the cost of work served from an item, by its handle. Requires DeficitStorage.
+     * @param handle The item's handle.
+     * @param cost The cost, in the same unit as the quanta.
+     * @return True if the item was charged, false if the handle is stale.
+     */
+    bool charge(Handle handle, uint64_t cost) {
+        return storage_.charge(handle, cost);
     }
 
     /**
      * @brief Attempts to retrieve the next item in the round-robin cycle.
      * @return A pointer to the next item, or nullptr if the container is empty.
-     * 
+     *
+     * Each call advances a persistent cursor by one position, so it runs in O(1)
+     * regardless of the number of items. Within one cycle every item is returned
+     * exactly once: items added mid-cycle are returned before the cycle ends, and
+     * items removed with remove_current() or remove() are not returned again,
+     * whatever their position in the cycle. WeightedStorage
+     * instead returns items in proportion to their weights, in O(log n).
+     *
      * This function respects the move semantics of the stored type T.
      */
     T* try_next() {
-        if (items_.empty()) {
-            current_ = items_.before_begin();
-            return nullptr;
-        }
-        
-        if (all_visited()) {
-            reset_visited();
-        }
-        
-        // Track previous position for potential removal
-        auto prev = items_.before_begin();
-        for (auto it = items_.begin(); it!= items_.end(); ++it) {
-            if (!it->visited) {
-                it->visited = true;
-                current_ = prev;  // Store previous iterator for remove_current()
-                return &it->value;
+        if constexpr (Stats::timed) {
+            auto start = std::chrono::steady_clock::now();
+            T* item = storage_.try_next();
+            stats_.on_select_time(std::chrono::steady_clock::now() - start);
+            if (item) {
+                record_select();
+            }
+            return item;
+        } else if constexpr (Stats::enabled) {
+            T* item = storage_.try_next();
+            if (item) {
+                record_select();
             }
-            prev = it;
+            return item;
+        } else {
+            return storage_.try_next();
         }
-        
-        // Should never reach here since we reset visits if all were visited
-        assert(!items_.empty()); // Defensive programming
-        current_ = items_.before_begin();
-        return &items_.front().value;
     }
 
     /**
      * @brief Retrieves the next item in the round-robin cycle, throwing if the container is empty.
      * @return A reference to the next item.
-     * 
+     *
      * This function is a convenience wrapper around try_next(), suitable for scenarios where
      * an empty container is considered an error.
      */
@@ -167,50 +460,361 @@ public:
         return *result;
     }
 
+    /**
+     * @brief Retrieves the next n items of the rotation in one pass.
+     * @param out Array of at least n pointers that receives the items.
+     * @param n Number of items to retrieve.
+     * @return n, or 0 if the container is empty.
+     *
+     * Equivalent to n calls to try_next(), but the storage walks its layout
+     * once instead of restarting for every item. If n exceeds size() the
+     * rotation wraps and items repeat. Afterwards the last item written to
+     * out is the current item for remove_current().
+     *
+     * With stats enabled this falls back to n calls to try_next(), so that
+     * every selection is attributed to its item.
+     */
+    size_t next_n(T** out, size_t n) {
+        return for_each_next(n, [&out](T& item) { *out++ = &item; });
+    }
+
+    /**
+     * @brief Calls fn on each of the next n items of the rotation.
+     * @param n Number of items to visit.
+     * @param fn Called with a T& for each item, in rotation order. It must not
+     *           add or remove items.
+     * @return n, or 0 if the container is empty.
+     *
+     * With stats enabled this falls back to n calls to try_next(), so that
+     * every selection is attributed to its item.
+     */
+    template<typename Fn>
+    size_t for_each_next(size_t n, Fn&& fn) {
+        if constexpr (Stats::enabled) {
+            for (size_t i = 0; i < n; ++i) {
+                T* item = try_next();
+                if (!item) {
+                    return 0;
+                }
+                fn(*item);
+            }
+            return n;
+        } else {
+            return storage_.for_each_next(n, std::forward<Fn>(fn));
+        }
+    }
+
     /**
      * @brief Removes the current item from the container.
-     * 
+     *
      * Should be called only after a successful call to next() or try_next().
      * The next call to next() or try_next() will return the next item in sequence.
-     * 
-     * @throws std::runtime_error if called before any next() or try_next() call, or if the container is empty.
+     *
+     * @throws std::runtime_error if called before any next() or try_next() call, if called twice
+     *         for the same item, or if the container is empty.
      */
     void remove_current() {
-        if (items_.empty()) {
+        if (empty()) {
             throw std::runtime_error("Attempted to remove from empty RoundRobin");
         }
-        
-        auto next = std::next(current_);
-        if (next == items_.end()) {
+
+        if (!storage_.has_current()) {
             throw std::runtime_error("Invalid current position in RoundRobin");
         }
-        
-        items_.erase_after(current_);
-        --count_;
-        
-        // If we removed the last item, reset current
-        if (items_.empty()) {
-            current_ = items_.before_begin();
+
+        if constexpr (Stats::enabled) {
+            stats_.on_remove(storage_.current_slot());
+        }
+        if constexpr (Affinity::enabled) {
+            affinity_.on_remove(storage_.current_slot());
+        }
+        storage_.erase_current();
+    }
+
+    /**
+     * @brief Takes the current item out of the rotation without destroying it.
+     *
+     * Meant for health checking: an item that failed (a backend that timed
+     * out, a worker that is draining) is suspended and skipped by next() at
+     * no extra cost until resume_if() puts it back. Suspending is O(1) for
+     * ListStorage and VectorStorage and O(log n) for WeightedStorage. The
+     * next call to next() or try_next() returns the item that would have
+     * followed the suspended one.
+     *
+     * Suspended items are not counted by size() or empty(); see
+     * suspended_count().
+     *
+     * @throws std::runtime_error under the same conditions as remove_current().
+     */
+    void suspend_current() {
+        if (empty()) {
+            throw std::runtime_error("Attempted to suspend from empty RoundRobin");
+        }
+
+        if (!storage_.has_current()) {
+            throw std::runtime_error("Invalid current position in RoundRobin");
+        }
+
+        storage_.suspend_current();
+    }
+
+    /**
+     * @brief Puts suspended items matching a predicate back into the rotation.
+     * @param pred Called with a const reference to each suspended item; returns
+     *        true for the items to resume.
+     * @return The number of items resumed.
+     *
+     * Only suspended items are examined, so this costs nothing proportional to
+     * the size of the rotation. Resumed items are visited before the current
+     * cycle ends.
+     */
+    template<typename Pred>
+    size_t resume_if(Pred pred) {
+        return storage_.resume_if(pred);
+    }
+
+    /**
+     * @brief Puts every suspended item back into the rotation.
+     * @return The number of items resumed.
+     */
+    size_t resume_all() {
+        return storage_.resume_if([](const T&) { return true; });
+    }
+
+    /**
+     * @brief Looks up an item by the handle add() returned for it.
+     * @param handle The item's handle.
+     * @return A pointer to the item, active or suspended, or nullptr if it
+     *         has been removed.
+     *
+     * O(1). A stale handle is detected by its generation and never reaches an
+     * item added later in the same slot.
+     */
+    T* get(Handle handle) {
+        return storage_.find(handle);
+    }
+
+    /**
+     * @brief Looks up an item by the handle add() returned for it, read-only.
+     * @param handle The item's handle.
+     * @return A pointer to the item, active or suspended, or nullptr if it
+     *         has been removed.
+     */
+    const T* get(Handle handle) const {
+        return storage_.find(handle);
+    }
+
+    /**
+     * @brief Checks whether the item a handle refers to is still in the container.
+     * @param handle The item's handle.
+     * @return True if get() would return the item.
+     */
+    bool contains(Handle handle) const {
+        return storage_.find(handle) != nullptr;
+    }
+
+    /**
+     * @brief Removes an item by its handle, wherever it is in the rotation.
+     * @param handle The item's handle.
+     * @return True if the item was removed, false if the handle is stale.
+     *
+     * O(1) for ListStorage and VectorStorage, O(log n) for WeightedStorage;
+     * suspended items can be removed too. The current cycle still visits
+     * every remaining item exactly once. If the removed item was the current
+     * one, remove_current() throws until the next call to next().
+     */
+    bool remove(Handle handle) {
+        if (!storage_.erase(handle)) {
+            return false;
+        }
+        if constexpr (Stats::enabled) {
+            stats_.on_remove(handle.index);
+        }
+        if constexpr (Affinity::enabled) {
+            affinity_.on_remove(handle.index);
         }
+        return true;
+    }
+
+    /**
+     * @brief Takes an item out of the rotation by its handle.
+     * @param handle The item's handle.
+     * @return True if the item was suspended, false if the handle is stale or
+     *         the item was already suspended.
+     */
+    bool suspend(Handle handle) {
+        return storage_.suspend(handle);
+    }
+
+    /**
+     * @brief Puts a suspended item back into the rotation by its handle.
+     * @param handle The item's handle.
+     * @return True if the item was resumed, false if the handle is stale or
+     *         the item was not suspended.
+     */
+    bool resume(Handle handle) {
+        return storage_.resume(handle);
+    }
+
+    /**
+     * @brief Selects the next item and checks it out exclusively.
+     * @return A Lease on the item, or an empty Lease if no item is available.
+     *
+     * Meant for connection pools: the item is taken out of the rotation like
+     * suspend_current() does, so it is skipped without any scanning until the
+     * Lease is destroyed. Leasing and returning are O(1) for ListStorage and
+     * VectorStorage and O(log n) for WeightedStorage. Leased items are not
+     * counted by size() or suspended_count(); see leased_count().
+     */
+    Lease try_lease() {
+        if (!try_next()) {
+            return Lease();
+        }
+        return Lease(this, storage_.lease_current());
+    }
+
+    /**
+     * @brief Selects the next item and checks it out exclusively, throwing if none is available.
+     * @return A Lease on the item.
+     */
+    Lease lease() {
+        Lease result = try_lease();
+        if (!result) {
+            throw std::runtime_error("Attempted to lease from empty RoundRobin");
+        }
+        return result;
+    }
+
+    /**
+     * @brief Retrieves the item a key sticks to. Requires KeyAffinity.
+     * @param key_hash Hash of the key (a session id, a cache key).
+     * @return A pointer to the key's item, or nullptr if the container is empty.
+     *
+     * O(1): one table lookup. The same key gets the same item for as long as
+     * the item is in the container; adding or removing an item moves only
+     * about 1/n of the keys. While the key's item is suspended or leased, the
+     * key falls back to the next of a few other items in a fixed, per-key
+     * order, so it still sticks to one item and returns home on resume.
+     *
+     * Keyed lookups neither advance the rotation nor change the current item,
+     * and are not counted by the stats policy. The exception is a key whose
+     * item and fallbacks are all suspended or leased: it is served by
+     * try_next(), which advances the rotation and is counted like any
+     * selection.
+     */
+    template<typename A = Affinity, typename = std::enable_if_t<A::enabled>>
+    T* try_next_for_key(uint64_t key_hash) {
+        for (unsigned probe = 0; probe < affinity_probes; ++probe) {
+            Handle handle = affinity_.lookup(key_hash, probe);
+            if (handle == Handle{}) {
+                return nullptr;
+            }
+            if (T* item = storage_.find_active(handle)) {
+                return item;
+            }
+        }
+        return try_next();
+    }
+
+    /**
+     * @brief Retrieves the item a key sticks to, throwing if the container is empty. Requires KeyAffinity.
+     * @param key_hash Hash of the key.
+     * @return A reference to the key's item.
+     */
+    template<typename A = Affinity, typename = std::enable_if_t<A::enabled>>
+    T& next_for_key(uint64_t key_hash) {
+        T* result = try_next_for_key(key_hash);
+        if (!result) {
+            throw std::runtime_error("Attempted to get next item from empty RoundRobin");
+        }
+        return *result;
     }
 
     /**
      * @brief Checks if the container is empty.
-     * @return True if the container is empty, false otherwise.
+     * @return True if no item is in the rotation, false otherwise.
      */
     bool empty() const {
-        return count_ == 0;
+        return storage_.size() == 0;
     }
 
     /**
-     * @brief Retrieves the number of items in the container.
-     * @return The count of items.
+     * @brief Retrieves the number of items in the rotation.
+     * @return The count of items, not including suspended ones.
      */
     size_t size() const {
-        return count_;
+        return storage_.size();
+    }
+
+    /**
+     * @brief Retrieves the number of suspended items.
+     * @return The count of items held out of the rotation.
+     */
+    size_t suspended_count() const {
+        return storage_.suspended_count();
+    }
+
+    /**
+     * @brief Retrieves the number of leased items.
+     * @return The count of items checked out by a live Lease.
+     */
+    size_t leased_count() const {
+        return storage_.leased_count();
+    }
+
+    /**
+     * @brief Takes a snapshot of the counters. Requires a Stats policy other than NoStats.
+     * @return Selections per item (indexed by Handle::index), total selections,
+     *         cycles, removals and, with TimedSelectionStats, the selection-time
+     *         histogram.
+     *
+     * May be called from another thread while this one keeps rotating; the
+     * counters are read with relaxed atomic loads.
+     */
+    template<typename S = Stats, typename = std::enable_if_t<S::enabled>>
+    typename S::Snapshot stats() const {
+        return stats_.snapshot();
+    }
+
+    /**
+     * @brief Exchanges the items and rotation state of two containers.
+     * @param other The RoundRobin instance to swap with.
+     *
+     * O(1) and allocation-free with the default NoStats policy, which suits
+     * double-buffered updates: fill a standby pool, then swap it in. Both
+     * containers keep their rotation state as described for the move
+     * constructor, and handles follow their items. Counters of an enabled
+     * stats policy are exchanged too, in time linear in the number of slots.
+     */
+    void swap(RoundRobin& other) noexcept(!Stats::enabled) {
+        storage_.swap(other.storage_);
+        if constexpr (Stats::enabled) {
+            std::swap(stats_, other.stats_);
+        }
+        if constexpr (Affinity::enabled) {
+            affinity_.swap(other.affinity_);
+        }
     }
 };
 
+/**
+ * @brief Exchanges the items and rotation state of two containers.
+ */
+template<typename T, template<typename, typename> class Storage, typename Allocator, typename Stats, typename Affinity>
+void swap(RoundRobin<T, Storage, Allocator, Stats, Affinity>& a,
+          RoundRobin<T, Storage, Allocator, Stats, Affinity>& b) noexcept(noexcept(a.swap(b))) {
+    a.swap(b);
+}
+
+/**
+ * @brief RoundRobin whose nodes come from a per-container PoolAllocator.
+ *
+ * Suited to pools with heavy churn: after warm-up, add() and remove_current()
+ * reuse freed nodes instead of going to the global allocator.
+ */
+template<typename T, template<typename, typename> class Storage = ListStorage>
+using PooledRoundRobin = RoundRobin<T, Storage, PoolAllocator<T>>;
+
 } // namespace rr
 
 #endif // ROUND_ROBIN_HPP
@@ -0,0 +1,445 @@
+#ifndef ROUND_ROBIN_SHARDED_ROUND_ROBIN_HPP
+#define ROUND_ROBIN_SHARDED_ROUND_ROBIN_HPP
+
+#include <algorithm> // For std::max
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility> // For std::move
+
+#if __has_include(<bit>)
+#include <bit>
+#endif
+
+#include "round_robin/round_robin.hpp"
+
+namespace rr {
+
+/**
+ * @brief A round-robin container split into per-thread shards.
+ *
+ * Each shard is a plain RoundRobin<T> behind its own mutex, on its own cache
+ * line. Every thread has a home shard and selects from it, so with one thread
+ * per shard the common path only touches that shard's lock and items and no
+ * cache line is shared between cores.
+ *
+ * add() places items in the shard with the fewest items, so shard sizes stay
+ * within one of each other while items are only added. When a thread finds its
+ * home shard empty (for example after removals drained it), it steals half of
+ * the items of the next non-empty shard and carries on from its own shard.
+ * Which shards hold items is also kept in a packed bitmask, so the search
+ * for a victim and empty() read one word per 64 shards, however many of
+ * them are empty, instead of one cache line per shard.
+ *
+ * Fairness is per shard: the threads homed on a shard visit its items in strict
+ * rotation. With the same number of threads on every shard and balanced shard
+ * sizes, every item is therefore selected at the same rate, and the skew between
+ * any two items is bounded by the difference in shard sizes. Unlike
+ * ConcurrentRoundRobin there is no global order across shards.
+ *
+ * A Ref holds its shard's lock. Calling any other member on the same thread
+ * while holding a Ref may deadlock.
+ *
+ * @tparam T The type of items stored in the round-robin container.
+ */
+template<typename T>
+class ShardedRoundRobin {
+private:
+    /**
+     * @struct Shard
+     * @brief One independently locked rotation, padded to its own cache lines.
+     */
+    struct alignas(64) Shard {
+        std::mutex mutex; ///< Guards items.
+        RoundRobin<T> items; ///< This shard's rotation.
+        std::atomic<size_t> size{0}; ///< Copy of items.size() that can be read without the lock.
+        std::atomic<uint64_t>* occupied_word = nullptr; ///< Word of the owner's occupied_ mask holding this shard's bit.
+        uint64_t occupied_bit = 0; ///< This shard's bit in *occupied_word.
+
+        /**
+         * @brief Publishes items.size() after a change. The shard's lock must be held.
+         *
+         * The mask bit only changes when the shard becomes empty or non-empty,
+         * so adds and removals in between touch no shared word.
+         */
+        void publish_size() {
+            const size_t count = items.size();
+            const bool was_empty = size.load(std::memory_order_relaxed) == 0;
+            size.store(count, std::memory_order_relaxed);
+            if (was_empty && count != 0) {
+                occupied_word->fetch_or(occupied_bit, std::memory_order_relaxed);
+            } else if (!was_empty && count == 0) {
+                occupied_word->fetch_and(~occupied_bit, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::unique_ptr<Shard[]> shards_; ///< The shards.
+    size_t shard_count_; ///< Number of shards.
+    std::unique_ptr<std::atomic<uint64_t>[]> occupied_; ///< Bit s set while shard s holds items; a hint, like Shard::size.
+    size_t occupied_words_; ///< Number of words in occupied_.
+
+    static unsigned count_trailing_zeros(uint64_t word) {
+#if defined(__cpp_lib_bitops)
+        return static_cast<unsigned>(std::countr_zero(word));
+#elif defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+        unsigned n = 0;
+        for (; (word & 1) == 0; word >>= 1) {
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    /**
+     * @brief Finds the first shard in [first, last) whose occupied bit is set.
+     * @return Its index, or last if there is none.
+     */
+    size_t find_occupied(size_t first, size_t last) const {
+        while (first < last) {
+            const size_t w = first / 64;
+            uint64_t word = occupied_[w].load(std::memory_order_relaxed) & (~uint64_t{0} << (first % 64));
+            if (word != 0) {
+                return std::min(w * 64 + count_trailing_zeros(word), last);
+            }
+            first = (w + 1) * 64;
+        }
+        return last;
+    }
+
+    /**
+     * @brief Finds the next occupied shard at or after position i of a wrapping search.
+     * @param i Position in [start, start + shard_count_); shard i % shard_count_.
+     * @param end One past the last position to search.
+     * @return The position of the shard found, or end.
+     */
+    size_t next_occupied(size_t i, size_t end) const {
+        if (i < shard_count_) {
+            const size_t last = std::min(end, shard_count_);
+            const size_t found = find_occupied(i, last);
+            if (found < last) {
+                return found;
+            }
+            i = last;
+        }
+        return i < end ? shard_count_ + find_occupied(i - shard_count_, end - shard_count_) : end;
+    }
+
+    /**
+     * @brief Returns a number unique to the calling thread, assigned in order of first use.
+     */
+    static size_t thread_ordinal() {
+        static std::atomic<size_t> next_ordinal{0};
+        static thread_local const size_t ordinal = next_ordinal.fetch_add(1, std::memory_order_relaxed);
+        return ordinal;
+    }
+
+    Shard& home_shard() const {
+        return shards_[thread_ordinal() % shard_count_];
+    }
+
+    /**
+     * @brief Moves half of a victim's items, rounded up, into an empty home shard.
+     *
+     * Both locks must be held. Items are taken in the victim's rotation order,
+     * starting where its cursor stands.
+     */
+    static void steal(Shard& home, Shard& victim) {
+        size_t count = (victim.items.size() + 1) / 2;
+        for (size_t i = 0; i < count; ++i) {
+            home.items.add(std::move(victim.items.next()));
+            victim.items.remove_current();
+        }
+        victim.publish_size();
+        home.publish_size();
+    }
+
+public:
+    /**
+     * @class Ref
+     * @brief Locked reference to a selected item.
+     *
+     * While a Ref is alive it holds the lock of the shard the item lives in, so
+     * the item can be used and removed safely. An empty Ref is returned by
+     * try_next() when the container is empty.
+     */
+    class Ref {
+    private:
+        std::unique_lock<std::mutex> lock_; ///< Lock of the item's shard, if any.
+        Shard* shard_ = nullptr; ///< Shard the item lives in.
+        T* item_ = nullptr; ///< The selected item, or nullptr.
+
+        friend class ShardedRoundRobin;
+
+        Ref(std::unique_lock<std::mutex> lock, Shard* shard, T* item)
+            : lock_(std::move(lock)), shard_(shard), item_(item) {}
+
+    public:
+        /**
+         * @brief Constructs an empty Ref.
+         */
+        Ref() = default;
+
+        Ref(Ref&& other) noexcept
+            : lock_(std::move(other.lock_)), shard_(other.shard_), item_(other.item_) {
+            other.shard_ = nullptr;
+            other.item_ = nullptr;
+        }
+
+        Ref& operator=(Ref&& other) noexcept {
+            if (this != &other) {
+                lock_ = std::move(other.lock_);
+                shard_ = other.shard_;
+                item_ = other.item_;
+                other.shard_ = nullptr;
+                other.item_ = nullptr;
+            }
+            return *this;
+        }
+
+        Ref(const Ref&) = delete;
+        Ref& operator=(const Ref&) = delete;
+
+        /**
+         * @brief Releases the item and its shard's lock early. The Ref becomes empty.
+         */
+        void reset() {
+            if (lock_.owns_lock()) {
+                lock_.unlock();
+            }
+            shard_ = nullptr;
+            item_ = nullptr;
+        }
+
+        /**
+         * @brief Removes the item from the container and releases the Ref.
+         * @throws std::runtime_error if the Ref is empty.
+         */
+        void remove() {
+            if (!item_) {
+                throw std::runtime_error("Attempted to remove through an empty ShardedRoundRobin::Ref");
+            }
+            shard_->items.remove_current();
+            shard_->publish_size();
+            reset();
+        }
+
+        /**
+         * @brief Returns a pointer to the item, or nullptr if the Ref is empty.
+         */
+        T* get() const {
+            return item_;
+        }
+
+        /**
+         * @brief Checks whether the Ref refers to an item.
+         */
+        explicit operator bool() const {
+            return item_ != nullptr;
+        }
+
+        T& operator*() const {
+            return *item_;
+        }
+
+        T* operator->() const {
+            return item_;
+        }
+    };
+
+    /**
+     * @brief Constructor, initializing an empty container.
+     * @param shards Number of shards; defaults to one per hardware thread.
+     */
+    explicit ShardedRoundRobin(size_t shards = std::thread::hardware_concurrency())
+        : shards_(new Shard[std::max<size_t>(shards, 1)])
+        , shard_count_(std::max<size_t>(shards, 1))
+        , occupied_(new std::atomic<uint64_t>[(shard_count_ + 63) / 64]())
+        , occupied_words_((shard_count_ + 63) / 64) {
+        for (size_t s = 0; s < shard_count_; ++s) {
+            shards_[s].occupied_word = &occupied_[s / 64];
+            shards_[s].occupied_bit = uint64_t{1} << (s % 64);
+        }
+    }
+
+    // Shared between threads by reference; neither copyable nor movable
+    ShardedRoundRobin(const ShardedRoundRobin&) = delete;
+    ShardedRoundRobin& operator=(const ShardedRoundRobin&) = delete;
+
+    /**
+     * @brief Adds a copyable item to the shard with the fewest items.
+     * @param item The item to add, copied into the container.
+     */
+    void add(const T& item) {
+        emplace(item);
+    }
+
+    /**
+     * @brief Adds a movable item to the shard with the fewest items.
+     * @param item The item to add, moved into the container.
+     */
+    void add(T&& item) {
+        emplace(std::move(item));
+    }
+
+    /**
+     * @brief Constructs an item in place in the shard with the fewest items.
+     * @param args Arguments forwarded to the constructor of T.
+     *
+     * Ties go to the calling thread's home shard, then to the next shards in order.
+     */
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        size_t start = thread_ordinal() % shard_count_;
+        Shard* target = &shards_[start];
+        size_t least = target->size.load(std::memory_order_relaxed);
+        for (size_t i = 1; i < shard_count_ && least != 0; ++i) {
+            Shard& shard = shards_[(start + i) % shard_count_];
+            size_t size = shard.size.load(std::memory_order_relaxed);
+            if (size < least) {
+                target = &shard;
+                least = size;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(target->mutex);
+        target->items.emplace(std::forward<Args>(args)...);
+        target->publish_size();
+    }
+
+    /**
+     * @brief Removes every item matching a predicate.
+     * @param pred Called with a const reference to each item.
+     * @return The number of items removed.
+     *
+     * Locks one shard at a time, so selections on other shards continue.
+     */
+    template<typename Pred>
+    size_t remove_if(Pred pred) {
+        size_t removed = 0;
+        for (size_t s = 0; s < shard_count_; ++s) {
+            Shard& shard = shards_[s];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            // One full rotation visits every item once; removals do not reorder the rest
+            for (size_t i = shard.items.size(); i > 0; --i) {
+                if (pred(static_cast<const T&>(shard.items.next()))) {
+                    shard.items.remove_current();
+                    ++removed;
+                }
+            }
+            shard.publish_size();
+        }
+        return removed;
+    }
+
+    /**
+     * @brief Attempts to retrieve the next item from the calling thread's shard.
+     * @return A Ref to the next item, or an empty Ref if the container is empty.
+     *
+     * If the home shard is empty, half the items of the next non-empty shard
+     * are moved into it first.
+     */
+    Ref try_next() {
+        Shard& home = home_shard();
+        std::unique_lock<std::mutex> home_lock(home.mutex);
+        if (T* item = home.items.try_next()) {
+            return Ref(std::move(home_lock), &home, item);
+        }
+        home_lock.unlock();
+
+        const size_t start = thread_ordinal() % shard_count_;
+        const size_t end = start + shard_count_;
+        for (size_t i = next_occupied(start + 1, end); i < end; i = next_occupied(i + 1, end)) {
+            Shard& victim = shards_[i % shard_count_];
+            std::unique_lock<std::mutex> victim_lock(victim.mutex, std::defer_lock);
+            std::lock(home_lock, victim_lock);
+            if (home.items.empty()) {
+                steal(home, victim);
+            }
+            victim_lock.unlock();
+            if (T* item = home.items.try_next()) {
+                return Ref(std::move(home_lock), &home, item);
+            }
+            home_lock.unlock();
+        }
+        return Ref();
+    }
+
+    /**
+     * @brief Retrieves the next item, throwing if the container is empty.
+     * @return A Ref to the next item.
+     */
+    Ref next() {
+        Ref result = try_next();
+        if (!result) {
+            throw std::runtime_error("Attempted to get next item from empty ShardedRoundRobin");
+        }
+        return result;
+    }
+
+    /**
+     * @brief Calls fn on each of the next n items of the calling thread's shard.
+     * @param n Number of items to visit.
+     * @param fn Called with a T& for each item, with the shard locked. It must
+     *           not call other members of this container.
+     * @return n, or 0 if the container is empty.
+     *
+     * The shard is locked once for the whole batch. If it is empty, items are
+     * stolen first as in try_next().
+     */
+    template<typename Fn>
+    size_t for_each_next(size_t n, Fn&& fn) {
+        if (n == 0) {
+            return 0;
+        }
+        Ref first = try_next();
+        if (!first) {
+            return 0;
+        }
+        fn(*first);
+        first.shard_->items.for_each_next(n - 1, fn);
+        return n;
+    }
+
+    /**
+     * @brief Checks if the container is empty.
+     * @return True if no shard holds an item, false otherwise.
+     */
+    bool empty() const {
+        for (size_t w = 0; w < occupied_words_; ++w) {
+            if (occupied_[w].load(std::memory_order_relaxed) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Retrieves the number of items in the container.
+     * @return The sum of the shard sizes; only exact while no thread is writing.
+     */
+    size_t size() const {
+        size_t total = 0;
+        for (size_t s = 0; s < shard_count_; ++s) {
+            total += shards_[s].size.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /**
+     * @brief Retrieves the number of shards.
+     */
+    size_t shard_count() const {
+        return shard_count_;
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_SHARDED_ROUND_ROBIN_HPP
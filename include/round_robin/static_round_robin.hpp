@@ -0,0 +1,189 @@
+#ifndef ROUND_ROBIN_STATIC_ROUND_ROBIN_HPP
+#define ROUND_ROBIN_STATIC_ROUND_ROBIN_HPP
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility> // For std::move
+
+namespace rr {
+
+/**
+ * @brief A fixed-capacity round-robin container with inline storage.
+ *
+ * Meant for pools whose members are known at build time (a fixed set of
+ * shards, queues or NIC channels). Items live in a std::array inside the
+ * object, so the container never allocates, and every member function is
+ * constexpr, so a pool can be built and rotated at compile time.
+ *
+ * The interface mirrors RoundRobin (add, try_next, next, remove_current,
+ * empty, size), so either can be passed to code templated on the container.
+ * Items come out in insertion order, and removal works like VectorStorage:
+ * the last item is moved into the freed place, which keeps the guarantee that
+ * every item is returned exactly once per cycle.
+ *
+ * When N is a power of two and the pool is full, the cursor wraps with a mask
+ * instead of a compare-and-reset.
+ *
+ * @tparam T The type of items stored; must be default constructible and move assignable.
+ * @tparam N The capacity.
+ */
+template<typename T, size_t N>
+class StaticRoundRobin {
+private:
+    static_assert(N > 0, "StaticRoundRobin needs a capacity of at least 1");
+
+    static constexpr bool power_of_two = (N & (N - 1)) == 0; ///< Whether the full pool can wrap with a mask.
+
+    std::array<T, N> items_{}; ///< Inline storage; items_[size_] onwards are default-constructed.
+    size_t size_ = 0; ///< Number of items stored.
+    size_t next_ = 0; ///< Index of the item due next; wraps once it reaches size_.
+    size_t current_ = 0; ///< Index of the most recently returned item.
+    bool current_valid_ = false; ///< True if items_[current_] is the one most recently returned.
+
+    constexpr void check_capacity(size_t count) const {
+        if (count > N) {
+            throw std::length_error("Attempted to add to full StaticRoundRobin");
+        }
+    }
+
+public:
+    /**
+     * @brief Default constructor, initializing an empty container.
+     */
+    constexpr StaticRoundRobin() = default;
+
+    /**
+     * @brief Constructor, initializing the container with the given items in order.
+     * @param items The initial items.
+     * @throws std::length_error if there are more than N items.
+     */
+    constexpr StaticRoundRobin(std::initializer_list<T> items) {
+        check_capacity(items.size());
+        for (const T& item : items) {
+            items_[size_++] = item;
+        }
+    }
+
+    /**
+     * @brief Adds a copyable item at the end of the rotation.
+     * @param item The item to add, copied into the container.
+     * @throws std::length_error if the container is full.
+     */
+    constexpr void add(const T& item) {
+        check_capacity(size_ + 1);
+        items_[size_++] = item;
+    }
+
+    /**
+     * @brief Adds a movable item at the end of the rotation.
+     * @param item The item to add, moved into the container.
+     * @throws std::length_error if the container is full.
+     */
+    constexpr void add(T&& item) {
+        check_capacity(size_ + 1);
+        items_[size_++] = std::move(item);
+    }
+
+    /**
+     * @brief Attempts to retrieve the next item in the round-robin cycle.
+     * @return A pointer to the next item, or nullptr if the container is empty.
+     */
+    constexpr T* try_next() {
+        if (size_ == 0) {
+            next_ = 0;
+            current_valid_ = false;
+            return nullptr;
+        }
+
+        size_t index = next_;
+        if (power_of_two && size_ == N) {
+            next_ = (index + 1) & (N - 1);
+        } else {
+            if (index >= size_) {
+                index = 0; // Wrap around and start a new cycle
+            }
+            next_ = index + 1;
+        }
+
+        current_ = index;
+        current_valid_ = true;
+        return &items_[index];
+    }
+
+    /**
+     * @brief Retrieves the next item in the round-robin cycle, throwing if the container is empty.
+     * @return A reference to the next item.
+     */
+    constexpr T& next() {
+        T* item = try_next();
+        if (!item) {
+            throw std::runtime_error("Attempted to get next item from empty StaticRoundRobin");
+        }
+        return *item;
+    }
+
+    /**
+     * @brief Removes the item most recently returned by next() or try_next().
+     *
+     * The last item is moved into the freed place and the cursor is pointed at
+     * it; it had not been visited yet in this cycle, so no item is skipped or
+     * repeated. The vacated slot is reset to a default-constructed T.
+     *
+     * @throws std::runtime_error if the container is empty or there is no current item.
+     */
+    constexpr void remove_current() {
+        if (empty()) {
+            throw std::runtime_error("Attempted to remove from empty StaticRoundRobin");
+        }
+        if (!current_valid_) {
+            throw std::runtime_error("Invalid current position in StaticRoundRobin");
+        }
+
+        size_t last = size_ - 1;
+        if (current_ != last) {
+            items_[current_] = std::move(items_[last]);
+        }
+        items_[last] = T{};
+        --size_;
+        next_ = current_;
+        current_valid_ = false;
+    }
+
+    /**
+     * @brief Checks if the container is empty.
+     * @return True if the container is empty, false otherwise.
+     */
+    constexpr bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Checks if the container is full.
+     * @return True if another add() would throw.
+     */
+    constexpr bool full() const {
+        return size_ == N;
+    }
+
+    /**
+     * @brief Retrieves the number of items in the container.
+     * @return The count of items.
+     */
+    constexpr size_t size() const {
+        return size_;
+    }
+
+    /**
+     * @brief Retrieves the capacity.
+     * @return N.
+     */
+    static constexpr size_t capacity() {
+        return N;
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_STATIC_ROUND_ROBIN_HPP
@@ -0,0 +1,227 @@
+#ifndef ROUND_ROBIN_STATS_HPP
+#define ROUND_ROBIN_STATS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "round_robin/handle.hpp"
+
+namespace rr {
+
+/**
+ * @brief Stats policy that records nothing; the default for RoundRobin.
+ *
+ * Every hook is guarded by `if constexpr (Stats::enabled)` in RoundRobin, so
+ * with this policy the instrumentation is compiled out entirely.
+ */
+struct NoStats {
+    static constexpr bool enabled = false; ///< Whether RoundRobin calls the hooks.
+    static constexpr bool timed = false; ///< Whether RoundRobin times selections.
+    static constexpr bool traced = false; ///< Whether RoundRobin reports adds.
+};
+
+/**
+ * @brief Stats policy that counts selections per item, cycles and removals.
+ *
+ * Counters are relaxed atomics written only by the thread that drives the
+ * RoundRobin (which is single-threaded anyway), with a plain load and store
+ * rather than a read-modify-write, so the hot path takes no locked
+ * instruction and shares no cache line with other containers. Any other
+ * thread can call snapshot() at any time without stopping the rotation.
+ *
+ * Per-item counters are indexed by the item's handle slot and live in
+ * fixed-size chunks that never move. The chunk directory is the only state
+ * guarded by a mutex, and it is only locked when it grows (rarely, on a
+ * selection of an item in a new chunk) and by snapshot().
+ *
+ * @tparam Timed Also keep a histogram of selection times. This reads the
+ *         steady clock twice per selection.
+ */
+template<bool Timed = false>
+class SelectionStats {
+public:
+    static constexpr bool enabled = true; ///< Whether RoundRobin calls the hooks.
+    static constexpr bool timed = Timed; ///< Whether RoundRobin times selections.
+    static constexpr bool traced = false; ///< Whether RoundRobin reports adds.
+    static constexpr size_t histogram_buckets = 64; ///< Bucket i counts times of [2^(i-1), 2^i) ns.
+
+    /**
+     * @struct Snapshot
+     * @brief Copy of all counters at one point in time.
+     *
+     * Taken without stopping the rotation, so counters are individually exact
+     * but may be a few selections apart from each other.
+     */
+    struct Snapshot {
+        std::vector<uint64_t> selections; ///< Selections per item, indexed by Handle::index.
+        uint64_t total_selections = 0; ///< Selections of all items, including removed ones.
+        uint64_t cycles = 0; ///< Times the cursor wrapped around to start a new cycle; rounds of virtual time for WeightedStorage.
+        uint64_t removals = 0; ///< Items removed.
+        std::array<uint64_t, histogram_buckets> selection_ns{}; ///< Selection-time histogram, empty unless Timed.
+
+        /**
+         * @brief Returns the selections of the item a handle refers to.
+         *
+         * Counts restart at zero when an item is removed, so for a stale handle
+         * this is the count of whichever item now uses the slot, if any.
+         */
+        uint64_t selections_of(Handle handle) const {
+            return handle.index < selections.size() ? selections[handle.index] : 0;
+        }
+    };
+
+private:
+    static constexpr size_t chunk_size = 1024; ///< Per-item counters per chunk.
+
+    using Counter = std::atomic<uint64_t>;
+    using Chunk = std::array<Counter, chunk_size>;
+
+    std::vector<std::unique_ptr<Chunk>> chunks_; ///< Per-item counters, chunk by chunk.
+    mutable std::mutex chunks_mutex_; ///< Guards growth of chunks_ against snapshot().
+    Counter total_{0}; ///< Selections of all items.
+    Counter cycles_{0}; ///< Cursor wraps reported by the storage.
+    Counter removals_{0}; ///< Items removed.
+    std::array<Counter, histogram_buckets> selection_ns_{}; ///< Selection-time histogram.
+
+    /**
+     * @brief Increments a counter that only the calling thread writes.
+     */
+    static void bump(Counter& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    Counter& counter_for(uint32_t slot) {
+        size_t chunk = slot / chunk_size;
+        if (chunk >= chunks_.size()) {
+            std::lock_guard<std::mutex> lock(chunks_mutex_);
+            while (chunks_.size() <= chunk) {
+                auto fresh = std::make_unique<Chunk>();
+                for (auto& counter : *fresh) {
+                    counter.store(0, std::memory_order_relaxed);
+                }
+                chunks_.push_back(std::move(fresh));
+            }
+        }
+        return (*chunks_[chunk])[slot % chunk_size];
+    }
+
+    void copy_from(const SelectionStats& other) {
+        Snapshot values = other.snapshot();
+        for (uint32_t slot = 0; slot < values.selections.size(); ++slot) {
+            if (values.selections[slot] != 0) {
+                counter_for(slot).store(values.selections[slot], std::memory_order_relaxed);
+            }
+        }
+        total_.store(values.total_selections, std::memory_order_relaxed);
+        cycles_.store(values.cycles, std::memory_order_relaxed);
+        removals_.store(values.removals, std::memory_order_relaxed);
+        for (size_t i = 0; i < histogram_buckets; ++i) {
+            selection_ns_[i].store(values.selection_ns[i], std::memory_order_relaxed);
+        }
+    }
+
+public:
+    SelectionStats() = default;
+
+    /**
+     * @brief Move constructor. Counters are copied; neither side may be in use.
+     */
+    SelectionStats(SelectionStats&& other) {
+        copy_from(other);
+        other.reset();
+    }
+
+    /**
+     * @brief Move assignment operator. Counters are copied; neither side may be in use.
+     */
+    SelectionStats& operator=(SelectionStats&& other) {
+        if (this != &other) {
+            reset();
+            copy_from(other);
+            other.reset();
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Records a selection.
+     * @param slot Handle slot of the selected item.
+     * @param cycles Cycle count reported by the storage after the selection.
+     */
+    void on_select(uint32_t slot, uint64_t cycles) {
+        bump(counter_for(slot));
+        bump(total_);
+        cycles_.store(cycles, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Records how long a selection took.
+     */
+    void on_select_time(std::chrono::nanoseconds elapsed) {
+        uint64_t ns = static_cast<uint64_t>(elapsed.count());
+        size_t bucket = 0;
+        while (ns != 0 && bucket + 1 < histogram_buckets) {
+            ns >>= 1;
+            ++bucket;
+        }
+        bump(selection_ns_[bucket]);
+    }
+
+    /**
+     * @brief Records a removal. The item's selection count restarts at zero.
+     * @param slot Handle slot of the removed item.
+     */
+    void on_remove(uint32_t slot) {
+        counter_for(slot).store(0, std::memory_order_relaxed);
+        bump(removals_);
+    }
+
+    /**
+     * @brief Copies all counters. Safe to call from any thread at any time.
+     */
+    Snapshot snapshot() const {
+        Snapshot result;
+        {
+            std::lock_guard<std::mutex> lock(chunks_mutex_);
+            result.selections.reserve(chunks_.size() * chunk_size);
+            for (const auto& chunk : chunks_) {
+                for (const auto& counter : *chunk) {
+                    result.selections.push_back(counter.load(std::memory_order_relaxed));
+                }
+            }
+        }
+        result.total_selections = total_.load(std::memory_order_relaxed);
+        result.cycles = cycles_.load(std::memory_order_relaxed);
+        result.removals = removals_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < histogram_buckets; ++i) {
+            result.selection_ns[i] = selection_ns_[i].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Zeroes every counter. Must not race with the rotation.
+     */
+    void reset() {
+        std::lock_guard<std::mutex> lock(chunks_mutex_);
+        chunks_.clear();
+        total_.store(0, std::memory_order_relaxed);
+        cycles_.store(0, std::memory_order_relaxed);
+        removals_.store(0, std::memory_order_relaxed);
+        for (auto& counter : selection_ns_) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+using TimedSelectionStats = SelectionStats<true>; ///< Counts plus a selection-time histogram.
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_STATS_HPP
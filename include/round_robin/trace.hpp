@@ -0,0 +1,259 @@
+#ifndef ROUND_ROBIN_TRACE_HPP
+#define ROUND_ROBIN_TRACE_HPP
+
+#include <algorithm> // For std::equal, std::min
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <utility> // For std::move
+#include <vector>
+
+namespace rr {
+
+/**
+ * @brief Operations recorded by TraceRecorder.
+ */
+enum class TraceOp : uint8_t {
+    add = 0, ///< An item entered the container; arg is its weight.
+    select = 1, ///< next() or try_next() returned the item.
+    remove = 2, ///< The item was removed.
+};
+
+/**
+ * @struct TraceEvent
+ * @brief One decoded trace event.
+ */
+struct TraceEvent {
+    TraceOp op; ///< What happened.
+    uint32_t slot; ///< Handle::index of the item it happened to.
+    uint32_t arg; ///< Weight for TraceOp::add, otherwise 0.
+};
+
+/**
+ * @struct Trace
+ * @brief A recorded sequence of operations, oldest first.
+ *
+ * Each event is packed into 64 bits: the operation in bits 62-63, the item's
+ * slot in bits 32-61 and the argument in bits 0-31. write() and read() use a
+ * small header followed by the events, all little-endian, so a trace captured
+ * on one host replays on any other.
+ */
+struct Trace {
+    static constexpr uint32_t version = 1; ///< File format version written by write().
+
+    std::vector<uint64_t> events; ///< Packed events, oldest first.
+    uint64_t dropped = 0; ///< Older events overwritten in the ring buffer before the snapshot.
+
+    static uint64_t encode(TraceOp op, uint32_t slot, uint32_t arg) {
+        return (uint64_t{static_cast<uint8_t>(op)} << 62) | (uint64_t{slot & 0x3fffffffu} << 32) | arg;
+    }
+
+    static TraceEvent decode(uint64_t event) {
+        return TraceEvent{static_cast<TraceOp>(event >> 62),
+                          static_cast<uint32_t>(event >> 32) & 0x3fffffffu,
+                          static_cast<uint32_t>(event)};
+    }
+
+    /**
+     * @brief Returns event i, decoded.
+     */
+    TraceEvent operator[](size_t i) const {
+        return decode(events[i]);
+    }
+
+    /**
+     * @brief Retrieves the number of events.
+     */
+    size_t size() const {
+        return events.size();
+    }
+
+    /**
+     * @brief Writes the trace in its binary format.
+     * @param out Stream opened in binary mode.
+     */
+    void write(std::ostream& out) const {
+        out.write(magic, sizeof(magic));
+        put(out, version);
+        put(out, dropped);
+        put(out, static_cast<uint64_t>(events.size()));
+        for (uint64_t event : events) {
+            put(out, event);
+        }
+    }
+
+    /**
+     * @brief Reads a trace written by write().
+     * @param in Stream opened in binary mode.
+     * @return The trace.
+     * @throws std::runtime_error if the stream does not hold a complete trace.
+     */
+    static Trace read(std::istream& in) {
+        char header[sizeof(magic)];
+        if (!in.read(header, sizeof(header)) || !std::equal(header, header + sizeof(header), magic)) {
+            throw std::runtime_error("Not a round-robin trace");
+        }
+        Trace trace;
+        if (get<uint32_t>(in) != version) {
+            throw std::runtime_error("Unsupported round-robin trace version");
+        }
+        trace.dropped = get<uint64_t>(in);
+        uint64_t count = get<uint64_t>(in);
+        trace.events.reserve(static_cast<size_t>(std::min<uint64_t>(count, 1u << 24)));
+        for (uint64_t i = 0; i < count; ++i) {
+            trace.events.push_back(get<uint64_t>(in));
+        }
+        return trace;
+    }
+
+private:
+    static constexpr char magic[8] = {'R', 'R', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+    template<typename U>
+    static void put(std::ostream& out, U value) {
+        char bytes[sizeof(U)];
+        for (size_t i = 0; i < sizeof(U); ++i) {
+            bytes[i] = static_cast<char>(value >> (8 * i));
+        }
+        out.write(bytes, sizeof(U));
+    }
+
+    template<typename U>
+    static U get(std::istream& in) {
+        unsigned char bytes[sizeof(U)];
+        if (!in.read(reinterpret_cast<char*>(bytes), sizeof(U))) {
+            throw std::runtime_error("Truncated round-robin trace");
+        }
+        U value = 0;
+        for (size_t i = 0; i < sizeof(U); ++i) {
+            value |= static_cast<U>(bytes[i]) << (8 * i);
+        }
+        return value;
+    }
+};
+
+/**
+ * @brief Stats policy that records adds, selections and removals into a ring buffer.
+ *
+ * Use it as the Stats parameter of RoundRobin to capture the exact operation
+ * sequence of a production pool, then feed stats() to Trace::write() and
+ * replay the file offline with the rr_replay tool against other storages.
+ *
+ * Each event is one relaxed 64-bit store into a fixed ring of Capacity
+ * events, which is allocated on first use; recording never allocates after
+ * that and never locks. The ring belongs to its container, and so to the one
+ * thread that drives it, so threads running their own pools record into
+ * their own buffers without sharing a cache line. When the ring is full the
+ * oldest events are overwritten and counted in Trace::dropped; rr_replay
+ * treats items it first sees mid-trace as present from the start.
+ *
+ * stats() may be called from another thread while the rotation continues.
+ * Events overwritten during the copy are detected and left out.
+ *
+ * Suspensions, leases and charges are not recorded.
+ *
+ * @tparam Capacity Ring size in events; a power of two.
+ */
+template<size_t Capacity = (size_t{1} << 16)>
+class TraceRecorder {
+public:
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "TraceRecorder capacity must be a power of two");
+
+    static constexpr bool enabled = true; ///< Whether RoundRobin calls the hooks.
+    static constexpr bool timed = false; ///< Whether RoundRobin times selections.
+    static constexpr bool traced = true; ///< Whether RoundRobin reports adds.
+
+    using Snapshot = Trace;
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> ring_; ///< The events, allocated on first use.
+    std::atomic<uint64_t> head_{0}; ///< Number of events recorded so far.
+
+    void push(uint64_t event) {
+        if (!ring_) {
+            ring_.reset(new std::atomic<uint64_t>[Capacity]);
+        }
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        ring_[head & (Capacity - 1)].store(event, std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+public:
+    TraceRecorder() = default;
+
+    /**
+     * @brief Move constructor, taking over the ring; other starts a new one on its next event.
+     */
+    TraceRecorder(TraceRecorder&& other) noexcept
+        : ring_(std::move(other.ring_))
+        , head_(other.head_.exchange(0, std::memory_order_relaxed)) {}
+
+    /**
+     * @brief Move assignment operator, taking over the ring. Neither side may be in use.
+     */
+    TraceRecorder& operator=(TraceRecorder&& other) noexcept {
+        if (this != &other) {
+            ring_ = std::move(other.ring_);
+            head_.store(other.head_.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Records an added item.
+     * @param slot Handle slot of the item.
+     * @param weight Its weight or quantum; 1 for unweighted storages.
+     */
+    void on_add(uint32_t slot, unsigned weight) {
+        push(Trace::encode(TraceOp::add, slot, weight));
+    }
+
+    /**
+     * @brief Records a selection.
+     * @param slot Handle slot of the selected item.
+     */
+    void on_select(uint32_t slot, uint64_t /*cycles*/) {
+        push(Trace::encode(TraceOp::select, slot, 0));
+    }
+
+    /**
+     * @brief Records a removal.
+     * @param slot Handle slot of the removed item.
+     */
+    void on_remove(uint32_t slot) {
+        push(Trace::encode(TraceOp::remove, slot, 0));
+    }
+
+    /**
+     * @brief Copies the events still in the ring, oldest first.
+     */
+    Trace snapshot() const {
+        Trace trace;
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t first = head > Capacity ? head - Capacity : 0;
+        trace.events.reserve(static_cast<size_t>(head - first));
+        for (uint64_t i = first; i < head; ++i) {
+            trace.events.push_back(ring_[i & (Capacity - 1)].load(std::memory_order_relaxed));
+        }
+        // Events the writer may have overwritten while they were copied, including
+        // one it may be storing right now, are dropped from the front
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t later = head_.load(std::memory_order_relaxed);
+        const uint64_t valid = later + 1 > Capacity ? later + 1 - Capacity : 0;
+        if (valid > first) {
+            size_t lost = static_cast<size_t>(std::min(valid, head) - first);
+            trace.events.erase(trace.events.begin(), trace.events.begin() + lost);
+            first += lost;
+        }
+        trace.dropped = first;
+        return trace;
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_TRACE_HPP
@@ -0,0 +1,525 @@
+#ifndef ROUND_ROBIN_VECTOR_STORAGE_HPP
+#define ROUND_ROBIN_VECTOR_STORAGE_HPP
+
+#include <algorithm> // For std::min
+#include <cstddef>
+#include <cstdint>
+#include <memory> // For std::allocator, std::allocator_traits
+#include <vector>
+#include <utility> // For std::move, std::swap
+
+#include "round_robin/handle.hpp"
+
+namespace rr {
+
+/**
+ * @brief Contiguous storage policy for RoundRobin.
+ *
+ * Items are kept in a single dense buffer and the rotation is a plain index
+ * walk over it, which makes cycling through small handles (ints, pointers,
+ * file descriptors) as cheap as iterating an array. Items come out in
+ * insertion order.
+ *
+ * Suspended items are kept past the active ones, followed by leased items at
+ * the back of the buffer, so the rotation never steps over either. The slot
+ * index of each item is kept in a parallel buffer, so the rotation itself
+ * only touches the items.
+ *
+ * The trade-off is address stability: adding an item may reallocate the
+ * buffer, and erasing or suspending one moves other items around, so
+ * pointers returned by try_next() are only valid until the next add(),
+ * erase_current(), suspend_current() or resume_if(), or the equivalent
+ * calls through a handle. Use ListStorage when stable addresses are required.
+ *
+ * @tparam T The type of items stored.
+ * @tparam Allocator Allocator for the item buffer.
+ */
+template<typename T, typename Allocator = std::allocator<T>>
+class VectorStorage {
+private:
+    using SlotIndexAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<uint32_t>;
+
+    std::vector<T, Allocator> items_; ///< Dense buffer: active items, then suspended ones, then leased ones.
+    std::vector<uint32_t, SlotIndexAllocator> slot_of_; ///< Slot table index of items_[i].
+    SlotTable<size_t, Allocator> slots_; ///< Maps handles to buffer indices.
+    size_t active_ = 0; ///< Number of active items at the front of items_.
+    size_t leased_begin_ = 0; ///< Index of the first leased item; suspended items lie in [active_, leased_begin_).
+    size_t next_ = 0; ///< Index of the item due next; items before it were already visited this cycle.
+    size_t current_ = 0; ///< Index of the most recently returned item.
+    bool current_valid_ = false; ///< True if items_[current_] is the one most recently returned.
+    uint64_t cycles_ = 0; ///< Number of times the cursor wrapped around.
+
+    void reset_cursor() {
+        next_ = 0;
+        current_ = 0;
+        current_valid_ = false;
+    }
+
+    /**
+     * @brief Exchanges two items, keeping handles and the current item pointing at them.
+     */
+    void swap_items(size_t a, size_t b) {
+        if (a == b) {
+            return;
+        }
+        std::swap(items_[a], items_[b]);
+        std::swap(slot_of_[a], slot_of_[b]);
+        slots_.set(slot_of_[a], a);
+        slots_.set(slot_of_[b], b);
+        if (current_ == a) {
+            current_ = b;
+        } else if (current_ == b) {
+            current_ = a;
+        }
+    }
+
+    /**
+     * @brief Gives handles to the items appended from index first onwards and
+     *        moves them into the active region.
+     *
+     * Each one is moved to the end of the suspended region and from there
+     * swapped with the first suspended item, so the new items end up right
+     * after the active ones, in the order they were appended.
+     */
+    template<typename OnAdd = IgnoreHandles>
+    Handle activate_appended(size_t first, OnAdd on_add = OnAdd()) {
+        Handle handle;
+        for (size_t i = first; i < items_.size(); ++i) {
+            handle = slots_.acquire(i);
+            on_add(handle);
+            slot_of_.push_back(handle.index);
+            swap_items(leased_begin_++, i);
+            activate(leased_begin_ - 1);
+        }
+        return handle;
+    }
+
+    /**
+     * @brief Moves the active item at index to the front of the suspended region.
+     *
+     * The rotation stays split into visited items before next_ and unvisited
+     * ones from next_ on. A visited item is first exchanged with the last
+     * visited one, and the freed place before next_ is then taken by the last
+     * active item, which has not been visited yet. Either way the items that
+     * remain keep their visited state, so none is skipped or repeated in the
+     * current cycle.
+     */
+    void deactivate(size_t index) {
+        if (current_valid_ && current_ == index) {
+            current_valid_ = false;
+        }
+        if (index < next_) {
+            swap_items(index, next_ - 1);
+            index = --next_;
+        }
+        swap_items(index, --active_);
+    }
+
+    /**
+     * @brief Erases the item at index, filling its place from the back of the buffer.
+     *
+     * The item is first moved to the front of the leased region, so that the
+     * final swap with the last item only reorders leased items.
+     */
+    void erase_at(size_t index) {
+        if (index < active_) {
+            deactivate(index);
+            index = active_;
+        }
+        if (index < leased_begin_) {
+            swap_items(index, --leased_begin_);
+            index = leased_begin_;
+        }
+        swap_items(index, items_.size() - 1);
+        slots_.release(slot_of_.back());
+        items_.pop_back();
+        slot_of_.pop_back();
+    }
+
+    /**
+     * @brief Moves the suspended item at index to the end of the active region.
+     */
+    void activate(size_t index) {
+        swap_items(index, active_++);
+    }
+
+    /**
+     * @brief Moves the active item at index to the front of the leased region.
+     */
+    void check_out(size_t index) {
+        deactivate(index);
+        swap_items(active_, --leased_begin_);
+    }
+
+    /**
+     * @brief Moves the leased item at index to the end of the active region.
+     */
+    void check_in(size_t index) {
+        swap_items(index, leased_begin_++);
+        activate(leased_begin_ - 1);
+    }
+
+public:
+    /**
+     * @brief Constructor, initializing empty storage.
+     * @param alloc Allocator used for the item buffer.
+     */
+    explicit VectorStorage(const Allocator& alloc = Allocator())
+        : items_(alloc)
+        , slot_of_(SlotIndexAllocator(alloc))
+        , slots_(alloc) {}
+
+    /**
+     * @brief Move constructor, in O(1). The rotation continues where other left off.
+     * @param other The storage to move from; left empty.
+     */
+    VectorStorage(VectorStorage&& other) noexcept
+        : VectorStorage(other.items_.get_allocator()) {
+        swap(other);
+    }
+
+    /**
+     * @brief Move assignment operator. The rotation continues where other left off.
+     * @param other The storage to move from; left empty.
+     * @return Reference to this storage after the move.
+     *
+     * O(1) apart from destroying the items this storage held before.
+     */
+    VectorStorage& operator=(VectorStorage&& other) noexcept {
+        if (this != &other) {
+            VectorStorage(std::move(other)).swap(*this);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Exchanges the items and rotation state of two storages in O(1).
+     * @param other The storage to swap with.
+     *
+     * The buffers are swapped, not copied, so handles follow their items.
+     */
+    void swap(VectorStorage& other) noexcept {
+        items_.swap(other.items_);
+        slot_of_.swap(other.slot_of_);
+        slots_.swap(other.slots_);
+        std::swap(active_, other.active_);
+        std::swap(leased_begin_, other.leased_begin_);
+        std::swap(next_, other.next_);
+        std::swap(current_, other.current_);
+        std::swap(current_valid_, other.current_valid_);
+        std::swap(cycles_, other.cycles_);
+    }
+
+    VectorStorage(const VectorStorage&) = delete;
+    VectorStorage& operator=(const VectorStorage&) = delete;
+
+    /**
+     * @brief Appends an item; it is visited before the current cycle ends.
+     * @param item The item to add, copied or moved into the storage.
+     * @return Handle to the new item.
+     */
+    template<typename U>
+    Handle add(U&& item) {
+        items_.push_back(std::forward<U>(item));
+        return activate_appended(items_.size() - 1);
+    }
+
+    /**
+     * @brief Constructs an item in place at the end of the active region.
+     * @param args Arguments forwarded to the constructor of T.
+     * @return Reference to the new item.
+     */
+    template<typename... Args>
+    T& emplace(Args&&... args) {
+        items_.emplace_back(std::forward<Args>(args)...);
+        activate_appended(items_.size() - 1);
+        return items_[active_ - 1];
+    }
+
+    /**
+     * @brief Appends a range of items in one pass, keeping their order.
+     * @param first Iterator to the first item to add.
+     * @param last Iterator past the last item to add.
+     * @param on_add Called with the handle of each new item, in order.
+     */
+    template<typename InputIt, typename OnAdd = IgnoreHandles>
+    void add_range(InputIt first, InputIt last, OnAdd on_add = OnAdd()) {
+        size_t old_size = items_.size();
+        items_.insert(items_.end(), first, last);
+        slot_of_.reserve(items_.size());
+        activate_appended(old_size, on_add);
+    }
+
+    /**
+     * @brief Reserves buffer space so the next n items are added without reallocating.
+     * @param n Total number of items to make room for.
+     */
+    void reserve(size_t n) {
+        items_.reserve(n);
+        slot_of_.reserve(n);
+        slots_.reserve(n);
+    }
+
+    /**
+     * @brief Advances the cursor and returns the item it lands on.
+     * @return A pointer to the next item, or nullptr if no item is active.
+     */
+    T* try_next() {
+        if (active_ == 0) {
+            reset_cursor();
+            return nullptr;
+        }
+
+        if (next_ >= active_) {
+            next_ = 0; // Wrap around and start a new cycle
+            ++cycles_;
+        }
+
+        current_ = next_;
+        current_valid_ = true;
+        return &items_[next_++];
+    }
+
+    /**
+     * @brief Advances the cursor n times, calling fn on each item it lands on.
+     * @param n Number of items to visit.
+     * @param fn Called with a reference to each item in rotation order.
+     * @return n, or 0 if no item is active.
+     *
+     * Visits the buffer in contiguous runs, wrapping at most once per cycle.
+     */
+    template<typename Fn>
+    size_t for_each_next(size_t n, Fn&& fn) {
+        if (active_ == 0) {
+            reset_cursor();
+            return 0;
+        }
+
+        size_t remaining = n;
+        while (remaining != 0) {
+            if (next_ >= active_) {
+                next_ = 0; // Wrap around and start a new cycle
+                ++cycles_;
+            }
+            size_t end = std::min(active_, next_ + remaining);
+            for (size_t i = next_; i < end; ++i) {
+                fn(items_[i]);
+            }
+            remaining -= end - next_;
+            next_ = end;
+        }
+
+        if (n != 0) {
+            current_ = next_ - 1;
+            current_valid_ = true;
+        }
+        return n;
+    }
+
+    /**
+     * @brief Checks whether there is a current item that can be erased.
+     * @return True if the most recently returned item is still stored.
+     */
+    bool has_current() const {
+        return current_valid_;
+    }
+
+    /**
+     * @brief Erases the most recently returned item by swap-and-pop.
+     *
+     * Requires has_current(). The item is first moved out of the active
+     * region as by suspend_current(), then exchanged with the last item in
+     * the buffer and popped.
+     */
+    void erase_current() {
+        erase_at(current_);
+    }
+
+    /**
+     * @brief Takes the most recently returned item out of the rotation in O(1).
+     *
+     * Requires has_current(). The item stays stored until it is resumed or
+     * the storage is destroyed.
+     */
+    void suspend_current() {
+        deactivate(current_);
+    }
+
+    /**
+     * @brief Checks out the most recently returned item in O(1).
+     * @return The item's handle, for unlease().
+     *
+     * Requires has_current(). The item moves to the leased region at the back
+     * of the buffer, where the rotation, resume_if() and resume() skip it until
+     * it is returned with unlease().
+     */
+    Handle lease_current() {
+        uint32_t slot = slot_of_[current_];
+        check_out(current_);
+        return slots_.handle_of(slot);
+    }
+
+    /**
+     * @brief Returns a leased item to the rotation, in O(1).
+     * @param handle The handle returned by lease_current().
+     * @return True if the item was returned, false if the handle is stale or
+     *         the item is not leased.
+     *
+     * The item joins the end of the active region, so it is visited before
+     * the current cycle ends.
+     */
+    bool unlease(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        if (!index || *index < leased_begin_) {
+            return false;
+        }
+        check_in(*index);
+        return true;
+    }
+
+    /**
+     * @brief Returns suspended items matching a predicate to the rotation.
+     * @param pred Called with a const reference to each suspended item.
+     * @return The number of items resumed.
+     *
+     * Only suspended items are examined. Resumed items join the end of the
+     * active region, so they are visited before the current cycle ends.
+     */
+    template<typename Pred>
+    size_t resume_if(Pred pred) {
+        size_t resumed = 0;
+        for (size_t i = active_; i < leased_begin_; ++i) {
+            if (pred(static_cast<const T&>(items_[i]))) {
+                activate(i);
+                ++resumed;
+            }
+        }
+        return resumed;
+    }
+
+    /**
+     * @brief Looks up the item a handle refers to, in O(1).
+     * @param handle A handle returned by add().
+     * @return A pointer to the item, or nullptr if the handle is stale.
+     */
+    T* find(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        return index ? &items_[*index] : nullptr;
+    }
+
+    /**
+     * @brief Looks up the item a handle refers to, read-only, in O(1).
+     */
+    const T* find(Handle handle) const {
+        const size_t* index = slots_.find(handle);
+        return index ? &items_[*index] : nullptr;
+    }
+
+    /**
+     * @brief Looks up an item by handle, only if it is in the rotation.
+     * @param handle A handle returned by add().
+     * @return A pointer to the item, or nullptr if the handle is stale or the
+     *         item is suspended or leased.
+     */
+    T* find_active(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        return index && *index < active_ ? &items_[*index] : nullptr;
+    }
+
+    /**
+     * @brief Erases the item a handle refers to, in O(1).
+     * @param handle A handle returned by add().
+     * @return True if the item was erased, false if the handle is stale.
+     */
+    bool erase(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        if (!index) {
+            return false;
+        }
+        erase_at(*index);
+        return true;
+    }
+
+    /**
+     * @brief Takes the item a handle refers to out of the rotation, in O(1).
+     * @param handle A handle returned by add().
+     * @return True if the item was suspended, false if the handle is stale or
+     *         the item is already suspended.
+     */
+    bool suspend(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        if (!index || *index >= active_) {
+            return false;
+        }
+        deactivate(*index);
+        return true;
+    }
+
+    /**
+     * @brief Returns the item a handle refers to to the rotation, in O(1).
+     * @param handle A handle returned by add().
+     * @return True if the item was resumed, false if the handle is stale or
+     *         the item is not suspended.
+     */
+    bool resume(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        if (!index || *index < active_ || *index >= leased_begin_) {
+            return false;
+        }
+        activate(*index);
+        return true;
+    }
+
+    /**
+     * @brief Returns the most recently returned item.
+     *
+     * Requires has_current().
+     */
+    T& current() {
+        return items_[current_];
+    }
+
+    /**
+     * @brief Returns the handle slot of the most recently returned item.
+     *
+     * Requires has_current().
+     */
+    uint32_t current_slot() const {
+        return slot_of_[current_];
+    }
+
+    /**
+     * @brief Returns how many times the cursor has wrapped around to start a new cycle.
+     */
+    uint64_t cycles() const {
+        return cycles_;
+    }
+
+    /**
+     * @brief Retrieves the number of items in the rotation.
+     * @return The count of active items.
+     */
+    size_t size() const {
+        return active_;
+    }
+
+    /**
+     * @brief Retrieves the number of suspended items.
+     * @return The count of items held out of the rotation.
+     */
+    size_t suspended_count() const {
+        return leased_begin_ - active_;
+    }
+
+    /**
+     * @brief Retrieves the number of leased items.
+     * @return The count of items checked out by lease_current().
+     */
+    size_t leased_count() const {
+        return items_.size() - leased_begin_;
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_VECTOR_STORAGE_HPP
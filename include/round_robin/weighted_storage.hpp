@@ -0,0 +1,706 @@
+#ifndef ROUND_ROBIN_WEIGHTED_STORAGE_HPP
+#define ROUND_ROBIN_WEIGHTED_STORAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory> // For std::allocator, std::allocator_traits
+#include <vector>
+#include <utility> // For std::move, std::swap
+
+#include "round_robin/handle.hpp"
+
+namespace rr {
+
+/**
+ * @brief Weighted storage policy for RoundRobin (smooth weighted round-robin).
+ *
+ * Each item is selected in proportion to its weight, and selections of a
+ * heavy item are spread between the others instead of arriving in a burst.
+ * This is stride scheduling: an item of weight w advances its pass by
+ * stride = 2^32 / w every time it is selected, and the item with the lowest
+ * pass is selected next. The items are kept in a binary min-heap ordered by
+ * pass, so selection, removal and weight changes are O(log n).
+ *
+ * A new item's first pass is placed somewhere within one stride of the most
+ * recently selected item. The offset follows a van der Corput sequence, so
+ * items of equal weight are spread evenly across a heavier item's stride
+ * instead of clustering together. With all weights equal this is plain
+ * rotation in a fixed order, and an item added mid-cycle is still visited
+ * before the cycle ends.
+ *
+ * Suspended and leased items are taken out of the heap and cost nothing per
+ * selection. A resumed or returned item is scheduled like a newly added one,
+ * so it does not get a burst of selections to make up for the time it was out.
+ *
+ * Items live in a dense buffer; pointers returned by try_next() are only valid
+ * until the next add() or erase, whether of the current item or through a
+ * handle.
+ *
+ * @tparam T The type of items stored.
+ * @tparam Allocator Allocator for T, rebound for the item and heap buffers.
+ */
+template<typename T, typename Allocator = std::allocator<T>>
+class WeightedStorage {
+private:
+    static constexpr uint64_t stride_base = uint64_t(1) << 32; ///< Stride of an item with weight 1.
+
+    /**
+     * @struct Item
+     * @brief Internal struct to hold items with their weight and scheduling credit.
+     */
+    struct Item {
+        T value; ///< The actual item stored.
+        unsigned weight; ///< Relative share of selections.
+        uint64_t stride; ///< Pass increment per selection, stride_base / weight.
+        uint64_t pass; ///< Virtual time at which the item is due next; lowest is selected.
+        uint64_t seq; ///< Insertion sequence, breaks ties between equal passes.
+        size_t heap_pos; ///< Position of this item in heap_, or in suspended_ while suspended.
+        uint32_t slot; ///< Index of this item's entry in the slot table.
+        bool suspended; ///< True while the item is held out of the rotation.
+        bool leased; ///< True while the item is checked out; it is then in neither heap_ nor suspended_.
+
+        /**
+         * @brief Constructor for Item, constructing the item in place.
+         * @param w The item's weight.
+         * @param p The item's first pass.
+         * @param s The item's insertion sequence.
+         * @param args Arguments forwarded to the constructor of T.
+         */
+        template<typename... Args>
+        Item(unsigned w, uint64_t p, uint64_t s, Args&&... args)
+            : value(std::forward<Args>(args)...), weight(w), stride(stride_base / w), pass(p), seq(s), heap_pos(0), slot(0), suspended(false), leased(false) {}
+    };
+
+    using ItemAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Item>;
+    using IndexAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<size_t>;
+
+    std::vector<Item, ItemAllocator> items_; ///< Dense buffer holding the items.
+    std::vector<size_t, IndexAllocator> heap_; ///< Min-heap of indices of active items, ordered by pass.
+    std::vector<size_t, IndexAllocator> suspended_; ///< Indices of suspended items, in no particular order.
+    size_t leased_ = 0; ///< Number of leased items.
+    SlotTable<size_t, Allocator> slots_; ///< Maps handles to buffer indices.
+    uint64_t vtime_ = 0; ///< Pass of the most recently selected item.
+    uint64_t seq_ = 0; ///< Next insertion sequence number.
+    size_t current_ = 0; ///< Index of the most recently returned item.
+    bool current_valid_ = false; ///< True if items_[current_] is the one most recently returned.
+
+    /**
+     * @brief Orders items by pass, then by insertion sequence.
+     *
+     * Passes are compared through their signed difference, so the order stays
+     * correct when the 64-bit counters wrap around.
+     */
+    bool before(size_t a, size_t b) const {
+        const Item& x = items_[a];
+        const Item& y = items_[b];
+        int64_t diff = static_cast<int64_t>(x.pass - y.pass);
+        if (diff != 0) {
+            return diff < 0;
+        }
+        return static_cast<int64_t>(x.seq - y.seq) < 0;
+    }
+
+    void place(size_t pos, size_t index) {
+        heap_[pos] = index;
+        items_[index].heap_pos = pos;
+    }
+
+    void sift_up(size_t pos) {
+        size_t index = heap_[pos];
+        while (pos > 0) {
+            size_t parent = (pos - 1) / 2;
+            if (!before(index, heap_[parent])) {
+                break;
+            }
+            place(pos, heap_[parent]);
+            pos = parent;
+        }
+        place(pos, index);
+    }
+
+    void sift_down(size_t pos) {
+        size_t index = heap_[pos];
+        const size_t count = heap_.size();
+        for (;;) {
+            size_t child = 2 * pos + 1;
+            if (child >= count) {
+                break;
+            }
+            if (child + 1 < count && before(heap_[child + 1], heap_[child])) {
+                ++child;
+            }
+            if (!before(heap_[child], index)) {
+                break;
+            }
+            place(pos, heap_[child]);
+            pos = child;
+        }
+        place(pos, index);
+    }
+
+    /**
+     * @brief Restores heap order after the pass of the item at pos changed.
+     */
+    void reheap(size_t pos) {
+        if (pos > 0 && before(heap_[pos], heap_[(pos - 1) / 2])) {
+            sift_up(pos);
+        } else {
+            sift_down(pos);
+        }
+    }
+
+    /**
+     * @brief Returns the first-pass offset, as a fraction of 2^32, for an insertion.
+     *
+     * Bit-reversing the insertion count gives 1/2, 1/4, 3/4, 1/8, ... so
+     * successive items land in the largest remaining gap.
+     */
+    static uint64_t first_pass_offset(uint64_t seq) {
+        uint32_t x = static_cast<uint32_t>(seq + 1);
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+        x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+        x = (x >> 16) | (x << 16);
+        return x;
+    }
+
+    /**
+     * @brief Schedules an item within one stride of the most recent selection.
+     */
+    void schedule(size_t index) {
+        Item& item = items_[index];
+        item.seq = seq_++;
+        item.pass = vtime_ + ((item.stride * first_pass_offset(item.seq)) >> 32);
+        heap_.push_back(index);
+        sift_up(heap_.size() - 1);
+    }
+
+    /**
+     * @brief Gives a handle to the item just appended and schedules it.
+     */
+    Handle link_back() {
+        size_t index = items_.size() - 1;
+        Handle handle = slots_.acquire(index);
+        items_[index].slot = handle.index;
+        schedule(index);
+        return handle;
+    }
+
+    /**
+     * @brief Takes the item at heap position pos out of the heap.
+     */
+    void heap_remove(size_t pos) {
+        size_t last_pos = heap_.size() - 1;
+        if (pos != last_pos) {
+            place(pos, heap_[last_pos]);
+            heap_.pop_back();
+            reheap(pos);
+        } else {
+            heap_.pop_back();
+        }
+    }
+
+    /**
+     * @brief Drops entry pos from suspended_, moving the last entry into its place.
+     */
+    void suspended_remove(size_t pos) {
+        size_t moved = suspended_.back();
+        suspended_[pos] = moved;
+        items_[moved].heap_pos = pos;
+        suspended_.pop_back();
+    }
+
+    void reset_cursor() {
+        current_ = 0;
+        current_valid_ = false;
+    }
+
+    /**
+     * @brief Erases the item at index, moving the last item into its place.
+     *
+     * The moved item's scheduling state is unaffected.
+     */
+    void erase_at(size_t index) {
+        Item& item = items_[index];
+        if (item.leased) {
+            --leased_;
+        } else if (item.suspended) {
+            suspended_remove(item.heap_pos);
+        } else {
+            heap_remove(item.heap_pos);
+        }
+        slots_.release(item.slot);
+        if (current_valid_ && current_ == index) {
+            current_valid_ = false;
+        }
+
+        // Fill its slot in the buffer with the last item
+        size_t last = items_.size() - 1;
+        if (index != last) {
+            items_[index] = std::move(items_[last]);
+            Item& moved = items_[index];
+            if (!moved.leased) {
+                (moved.suspended ? suspended_ : heap_)[moved.heap_pos] = index;
+            }
+            slots_.set(moved.slot, index);
+            if (current_ == last) {
+                current_ = index;
+            }
+        }
+        items_.pop_back();
+    }
+
+    void suspend_at(size_t index) {
+        Item& item = items_[index];
+        heap_remove(item.heap_pos);
+        item.suspended = true;
+        item.heap_pos = suspended_.size();
+        suspended_.push_back(index);
+        if (current_valid_ && current_ == index) {
+            current_valid_ = false;
+        }
+    }
+
+    void resume_at(size_t index) {
+        suspended_remove(items_[index].heap_pos);
+        items_[index].suspended = false;
+        schedule(index);
+    }
+
+    /**
+     * @brief Changes the weight of the item at index, in O(log n).
+     *
+     * An item in the heap keeps its place in virtual time relative to the
+     * most recent selection, scaled by the ratio of the new stride to the old:
+     * the current item is due one new stride after it was served, and an item
+     * halfway to its turn stays halfway. Suspended and leased items only take
+     * the new stride, since they are rescheduled when they come back.
+     */
+    void set_weight_at(size_t index, unsigned weight) {
+        Item& item = items_[index];
+        const uint64_t old_stride = item.stride;
+        item.weight = weight;
+        item.stride = stride_base / weight;
+        if (item.suspended || item.leased) {
+            return;
+        }
+        int64_t ahead = static_cast<int64_t>(item.pass - vtime_);
+        uint64_t remaining = ahead > 0 ? static_cast<uint64_t>(ahead) : 0;
+        // Split so that neither product can overflow; strides are at most 2^32
+        item.pass = vtime_ + remaining / old_stride * item.stride
+                  + remaining % old_stride * item.stride / old_stride;
+        reheap(item.heap_pos);
+    }
+
+public:
+    /**
+     * @brief Constructor, initializing empty storage.
+     * @param alloc Allocator used for the item and heap buffers.
+     */
+    explicit WeightedStorage(const Allocator& alloc = Allocator())
+        : items_(ItemAllocator(alloc))
+        , heap_(IndexAllocator(alloc))
+        , suspended_(IndexAllocator(alloc))
+        , slots_(alloc) {}
+
+    /**
+     * @brief Move constructor, in O(1). Weights and scheduling state move with the items.
+     * @param other The storage to move from; left empty.
+     */
+    WeightedStorage(WeightedStorage&& other) noexcept
+        : WeightedStorage(Allocator(other.items_.get_allocator())) {
+        swap(other);
+    }
+
+    /**
+     * @brief Move assignment operator. Weights and scheduling state move with the items.
+     * @param other The storage to move from; left empty.
+     * @return Reference to this storage after the move.
+     *
+     * O(1) apart from destroying the items this storage held before.
+     */
+    WeightedStorage& operator=(WeightedStorage&& other) noexcept {
+        if (this != &other) {
+            WeightedStorage(std::move(other)).swap(*this);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Exchanges the items and scheduling state of two storages in O(1).
+     * @param other The storage to swap with.
+     */
+    void swap(WeightedStorage& other) noexcept {
+        items_.swap(other.items_);
+        heap_.swap(other.heap_);
+        suspended_.swap(other.suspended_);
+        slots_.swap(other.slots_);
+        std::swap(vtime_, other.vtime_);
+        std::swap(seq_, other.seq_);
+        std::swap(leased_, other.leased_);
+        std::swap(current_, other.current_);
+        std::swap(current_valid_, other.current_valid_);
+    }
+
+    WeightedStorage(const WeightedStorage&) = delete;
+    WeightedStorage& operator=(const WeightedStorage&) = delete;
+
+    /**
+     * @brief Adds an item with weight 1.
+     * @param item The item to add, copied or moved into the storage.
+     */
+    template<typename U>
+    Handle add(U&& item) {
+        return add(std::forward<U>(item), 1u);
+    }
+
+    /**
+     * @brief Adds an item with the given weight.
+     * @param item The item to add, copied or moved into the storage.
+     * @param weight Relative share of selections; must be at least 1.
+     * @return Handle to the new item.
+     */
+    template<typename U>
+    Handle add(U&& item, unsigned weight) {
+        items_.emplace_back(weight, 0, 0, std::forward<U>(item));
+        return link_back();
+    }
+
+    /**
+     * @brief Constructs an item with weight 1 in place.
+     * @param args Arguments forwarded to the constructor of T.
+     * @return Reference to the new item.
+     */
+    template<typename... Args>
+    T& emplace(Args&&... args) {
+        return emplace_weighted(1u, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Constructs an item with the given weight in place.
+     * @param weight Relative share of selections; must be at least 1.
+     * @param args Arguments forwarded to the constructor of T.
+     * @return Reference to the new item.
+     */
+    template<typename... Args>
+    T& emplace_weighted(unsigned weight, Args&&... args) {
+        items_.emplace_back(weight, 0, 0, std::forward<Args>(args)...);
+        link_back();
+        return items_.back().value;
+    }
+
+    /**
+     * @brief Adds a range of items with weight 1, keeping their order.
+     * @param first Iterator to the first item to add.
+     * @param last Iterator past the last item to add.
+     * @param on_add Called with the handle of each new item, in order.
+     */
+    template<typename InputIt, typename OnAdd = IgnoreHandles>
+    void add_range(InputIt first, InputIt last, OnAdd on_add = OnAdd()) {
+        for (; first != last; ++first) {
+            items_.emplace_back(1u, 0, 0, *first);
+            on_add(link_back());
+        }
+    }
+
+    /**
+     * @brief Reserves space so the next n items are added without reallocating.
+     * @param n Total number of items to make room for.
+     */
+    void reserve(size_t n) {
+        items_.reserve(n);
+        heap_.reserve(n);
+        slots_.reserve(n);
+    }
+
+    /**
+     * @brief Selects the item with the lowest pass and advances it by its stride.
+     * @return A pointer to the selected item, or nullptr if no item is active.
+     */
+    T* try_next() {
+        if (heap_.empty()) {
+            reset_cursor();
+            return nullptr;
+        }
+
+        size_t index = heap_[0];
+        Item& item = items_[index];
+        vtime_ = item.pass;
+        item.pass += item.stride;
+        sift_down(0);
+
+        current_ = index;
+        current_valid_ = true;
+        return &item.value;
+    }
+
+    /**
+     * @brief Makes n selections, calling fn on each selected item.
+     * @param n Number of selections.
+     * @param fn Called with a reference to each selected item, in order.
+     * @return n, or 0 if no item is active.
+     */
+    template<typename Fn>
+    size_t for_each_next(size_t n, Fn&& fn) {
+        if (heap_.empty()) {
+            reset_cursor();
+            return 0;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            fn(*try_next());
+        }
+        return n;
+    }
+
+    /**
+     * @brief Checks whether there is a current item that can be erased.
+     * @return True if the most recently returned item is still stored.
+     */
+    bool has_current() const {
+        return current_valid_;
+    }
+
+    /**
+     * @brief Erases the most recently returned item.
+     *
+     * Requires has_current(). The last item in the buffer is moved into its
+     * place; its scheduling state is unaffected.
+     */
+    void erase_current() {
+        erase_at(current_);
+        reset_cursor();
+    }
+
+    /**
+     * @brief Takes the most recently returned item out of the rotation in O(log n).
+     *
+     * Requires has_current(). The item keeps its weight while suspended.
+     */
+    void suspend_current() {
+        suspend_at(current_);
+        reset_cursor();
+    }
+
+    /**
+     * @brief Checks out the most recently returned item in O(log n).
+     * @return The item's handle, for unlease().
+     *
+     * Requires has_current(). The item is taken out of the heap and is skipped
+     * by the rotation, resume_if() and resume() until it is returned with
+     * unlease(). It keeps its weight meanwhile.
+     */
+    Handle lease_current() {
+        Item& item = items_[current_];
+        heap_remove(item.heap_pos);
+        item.leased = true;
+        ++leased_;
+        Handle handle = slots_.handle_of(item.slot);
+        reset_cursor();
+        return handle;
+    }
+
+    /**
+     * @brief Returns a leased item to the rotation, in O(log n).
+     * @param handle The handle returned by lease_current().
+     * @return True if the item was returned, false if the handle is stale or
+     *         the item is not leased.
+     */
+    bool unlease(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        if (!index || !items_[*index].leased) {
+            return false;
+        }
+        items_[*index].leased = false;
+        --leased_;
+        schedule(*index);
+        return true;
+    }
+
+    /**
+     * @brief Returns suspended items matching a predicate to the rotation.
+     * @param pred Called with a const reference to each suspended item.
+     * @return The number of items resumed.
+     *
+     * Only suspended items are examined. Each resumed item is scheduled as
+     * if it had just been added, O(log n) per item.
+     */
+    template<typename Pred>
+    size_t resume_if(Pred pred) {
+        size_t resumed = 0;
+        size_t pos = 0;
+        while (pos < suspended_.size()) {
+            size_t index = suspended_[pos];
+            if (pred(static_cast<const T&>(items_[index].value))) {
+                resume_at(index);
+                ++resumed;
+            } else {
+                ++pos;
+            }
+        }
+        return resumed;
+    }
+
+    /**
+     * @brief Looks up the item a handle refers to, in O(1).
+     * @param handle A handle returned by add().
+     * @return A pointer to the item, or nullptr if the handle is stale.
+     */
+    T* find(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        return index ? &items_[*index].value : nullptr;
+    }
+
+    /**
+     * @brief Looks up the item a handle refers to, read-only, in O(1).
+     */
+    const T* find(Handle handle) const {
+        const size_t* index = slots_.find(handle);
+        return index ? &items_[*index].value : nullptr;
+    }
+
+    /**
+     * @brief Looks up an item by handle, only if it is in the rotation.
+     * @param handle A handle returned by add().
+     * @return A pointer to the item, or nullptr if the handle is stale or the
+     *         item is suspended or leased.
+     */
+    T* find_active(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        if (!index || items_[*index].suspended || items_[*index].leased) {
+            return nullptr;
+        }
+        return &items_[*index].value;
+    }
+
+    /**
+     * @brief Erases the item a handle refers to, in O(log n).
+     * @param handle A handle returned by add().
+     * @return True if the item was erased, false if the handle is stale.
+     */
+    bool erase(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        if (!index) {
+            return false;
+        }
+        erase_at(*index);
+        return true;
+    }
+
+    /**
+     * @brief Takes the item a handle refers to out of the rotation, in O(log n).
+     * @param handle A handle returned by add().
+     * @return True if the item was suspended, false if the handle is stale or
+     *         the item is already suspended.
+     */
+    bool suspend(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        if (!index || items_[*index].suspended || items_[*index].leased) {
+            return false;
+        }
+        suspend_at(*index);
+        return true;
+    }
+
+    /**
+     * @brief Returns the item a handle refers to to the rotation, in O(log n).
+     * @param handle A handle returned by add().
+     * @return True if the item was resumed, false if the handle is stale or
+     *         the item is not suspended.
+     */
+    bool resume(Handle handle) {
+        const size_t* index = slots_.find(handle);
+        if (!index || !items_[*index].suspended) {
+            return false;
+        }
+        resume_at(*index);
+        return true;
+    }
+
+    /**
+     * @brief Returns the weight of the most recently returned item.
+     *
+     * Requires has_current().
+     */
+    unsigned current_weight() const {
+        return items_[current_].weight;
+    }
+
+    /**
+     * @brief Changes the weight of the most recently returned item in O(log n).
+     * @param weight The new weight; must be at least 1.
+     *
+     * Requires has_current(). The item is rescheduled one new stride after
+     * the point where it was last selected.
+     */
+    void set_current_weight(unsigned weight) {
+        set_weight_at(current_, weight);
+    }
+
+    /**
+     * @brief Changes the weight of the item a handle refers to, in O(log n).
+     * @param handle A handle returned by add().
+     * @param weight The new weight; must be at least 1.
+     * @return True if the weight was changed, false if the handle is stale.
+     *
+     * Works on suspended and leased items too; they are scheduled with the
+     * new weight when they return to the rotation.
+     */
+    bool set_weight(Handle handle, unsigned weight) {
+        const size_t* index = slots_.find(handle);
+        if (!index) {
+            return false;
+        }
+        set_weight_at(*index, weight);
+        return true;
+    }
+
+    /**
+     * @brief Returns the handle slot of the most recently returned item.
+     *
+     * Requires has_current().
+     */
+    uint32_t current_slot() const {
+        return items_[current_].slot;
+    }
+
+    /**
+     * @brief Returns the round of virtual time the most recent selection fell in.
+     *
+     * A round is one stride of a weight-1 item, so every pass crosses each round
+     * boundary exactly once: an item present for a whole round is selected once
+     * per unit of weight in it, whenever it was added or resumed. The count is
+     * derived from the last selected pass, so starting a round costs nothing.
+     */
+    uint64_t cycles() const {
+        return vtime_ / stride_base;
+    }
+
+    /**
+     * @brief Retrieves the number of items in the rotation.
+     * @return The count of active items.
+     */
+    size_t size() const {
+        return heap_.size();
+    }
+
+    /**
+     * @brief Retrieves the number of suspended items.
+     * @return The count of items held out of the rotation.
+     */
+    size_t suspended_count() const {
+        return suspended_.size();
+    }
+
+    /**
+     * @brief Retrieves the number of leased items.
+     * @return The count of items checked out by lease_current().
+     */
+    size_t leased_count() const {
+        return leased_;
+    }
+};
+
+} // namespace rr
+
+#endif // ROUND_ROBIN_WEIGHTED_STORAGE_HPP
@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+#include "round_robin/round_robin.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+template<typename RR>
+class AffinityTest : public ::testing::Test {
+protected:
+    static constexpr uint64_t keys = 10000;
+
+    RR rr;
+
+    /** Returns the item each of the first `keys` key hashes maps to. */
+    std::vector<int> owners() {
+        std::vector<int> result;
+        for (uint64_t key = 0; key < keys; ++key) {
+            result.push_back(this->rr.next_for_key(key));
+        }
+        return result;
+    }
+};
+
+template<template<typename, typename> class Storage>
+using KeyedRoundRobin = rr::RoundRobin<int, Storage, std::allocator<int>, rr::NoStats, rr::KeyAffinity>;
+
+using AffinityTypes = ::testing::Types<
+    KeyedRoundRobin<rr::ListStorage>,
+    KeyedRoundRobin<rr::VectorStorage>,
+    KeyedRoundRobin<rr::WeightedStorage>,
+    KeyedRoundRobin<rr::DeficitStorage>>;
+TYPED_TEST_SUITE(AffinityTest, AffinityTypes);
+
+TYPED_TEST(AffinityTest, EmptyContainer) {
+    EXPECT_EQ(this->rr.try_next_for_key(42), nullptr);
+    EXPECT_THROW(this->rr.next_for_key(42), std::runtime_error);
+    rr::Handle handle = this->rr.add(1);
+    this->rr.remove(handle);
+    EXPECT_EQ(this->rr.try_next_for_key(42), nullptr);
+}
+
+TYPED_TEST(AffinityTest, KeysStickAndSpreadEvenly) {
+    for (int i = 0; i < 10; ++i) {
+        this->rr.add(i);
+    }
+    std::vector<int> first = this->owners();
+    // Rotating does not disturb the mapping
+    for (int i = 0; i < 7; ++i) {
+        this->rr.next();
+    }
+    EXPECT_EQ(this->owners(), first);
+
+    std::vector<uint64_t> per_item(10);
+    for (int owner : first) {
+        ++per_item[owner];
+    }
+    for (uint64_t count : per_item) {
+        EXPECT_GT(count, this->keys / 10 * 8 / 10);
+        EXPECT_LT(count, this->keys / 10 * 12 / 10);
+    }
+}
+
+TYPED_TEST(AffinityTest, RemovalMovesOnlyKeysOfRemovedItem) {
+    std::vector<rr::Handle> handles;
+    for (int i = 0; i < 10; ++i) {
+        handles.push_back(this->rr.add(i));
+    }
+    std::vector<int> before = this->owners();
+    this->rr.remove(handles[3]);
+    std::vector<int> after = this->owners();
+
+    for (uint64_t key = 0; key < this->keys; ++key) {
+        if (before[key] == 3) {
+            EXPECT_NE(after[key], 3);
+        } else {
+            EXPECT_EQ(after[key], before[key]);
+        }
+    }
+}
+
+TYPED_TEST(AffinityTest, AdditionMovesKeysOnlyToNewItem) {
+    // Growing one item at a time also crosses several table doublings
+    this->rr.add(0);
+    std::vector<int> before = this->owners();
+    for (int i = 1; i < 100; ++i) {
+        this->rr.add(i);
+        std::vector<int> after = this->owners();
+        uint64_t moved = 0;
+        for (uint64_t key = 0; key < this->keys; ++key) {
+            if (after[key] != before[key]) {
+                EXPECT_EQ(after[key], i);
+                ++moved;
+            }
+        }
+        EXPECT_LT(moved, 2 * this->keys / (i + 1) + 100);
+        before = after;
+    }
+}
+
+TYPED_TEST(AffinityTest, RemoveCurrentAndAddRangeKeepIndexInSync) {
+    std::vector<int> items{0, 1, 2, 3};
+    this->rr.add_range(items.begin(), items.end());
+    int removed = this->rr.next();
+    this->rr.remove_current();
+    for (int owner : this->owners()) {
+        EXPECT_NE(owner, removed);
+    }
+    this->rr.emplace(4);
+    bool seen_new = false;
+    for (int owner : this->owners()) {
+        seen_new |= owner == 4;
+    }
+    EXPECT_TRUE(seen_new);
+}
+
+TYPED_TEST(AffinityTest, SuspendedItemFallsBackStickily) {
+    std::vector<rr::Handle> handles;
+    for (int i = 0; i < 5; ++i) {
+        handles.push_back(this->rr.add(i));
+    }
+    std::vector<int> home = this->owners();
+    ASSERT_TRUE(this->rr.suspend(handles[2]));
+
+    std::vector<int> fallback = this->owners();
+    for (uint64_t key = 0; key < this->keys; ++key) {
+        EXPECT_NE(fallback[key], 2);
+        if (home[key] != 2) {
+            EXPECT_EQ(fallback[key], home[key]);
+        }
+    }
+    EXPECT_EQ(this->owners(), fallback);
+
+    ASSERT_TRUE(this->rr.resume(handles[2]));
+    EXPECT_EQ(this->owners(), home);
+}
+
+TEST(AffinityTest, LeasedItemIsNotHandedOut) {
+    KeyedRoundRobin<rr::VectorStorage> rr;
+    rr.add(0);
+    rr.add(1);
+    auto lease = rr.lease();
+    for (uint64_t key = 0; key < 100; ++key) {
+        EXPECT_NE(&rr.next_for_key(key), lease.get());
+    }
+}
+
+TEST(AffinityTest, AllSuspendedFallsBackToRotation) {
+    KeyedRoundRobin<rr::ListStorage> rr;
+    rr::Handle a = rr.add(0);
+    rr.suspend(a);
+    EXPECT_EQ(rr.try_next_for_key(7), nullptr);
+    rr.add(1);
+    EXPECT_EQ(rr.next_for_key(7), 1);
+}
+
+TEST(AffinityTest, ExhaustedProbesAreServedByRotation) {
+    rr::RoundRobin<int, rr::VectorStorage, std::allocator<int>, rr::SelectionStats<>, rr::KeyAffinity> rr;
+    std::vector<rr::Handle> handles;
+    for (int i = 0; i < 4; ++i) {
+        handles.push_back(rr.add(i));
+    }
+    rr.suspend(handles[0]);
+    rr.suspend(handles[1]);
+
+    // About one key in 256 has every probe on a suspended item
+    uint64_t key = 0;
+    int* item = nullptr;
+    for (; key < 100000; ++key) {
+        item = rr.try_next_for_key(key);
+        if (rr.stats().total_selections != 0) {
+            break;
+        }
+    }
+    ASSERT_LT(key, 100000u);
+    ASSERT_NE(item, nullptr);
+    EXPECT_GE(*item, 2);
+    EXPECT_EQ(rr.stats().total_selections, 1u);
+    // The rotation moved past the item the key got
+    EXPECT_EQ(rr.next(), 5 - *item);
+    EXPECT_EQ(*rr.try_next_for_key(key), *item);
+}
+
+TEST(AffinityTest, LargeBatchIsIndexedInLinearTime) {
+    // Rebalancing the whole table on every add made this take minutes
+    const int count = 50000;
+    std::vector<int> items(count);
+    std::iota(items.begin(), items.end(), 0);
+    auto start = std::chrono::steady_clock::now();
+    KeyedRoundRobin<rr::VectorStorage> batch;
+    batch.add_range(items.begin(), items.end());
+    batch.next_for_key(0);
+    // Indexed one item at a time, each add taking over only its own share
+    KeyedRoundRobin<rr::VectorStorage> incremental;
+    incremental.reserve(count);
+    for (int item : items) {
+        incremental.add(item);
+        incremental.next_for_key(static_cast<uint64_t>(item));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(20));
+
+    // Every item got its share of keys, and one more add only takes keys for itself
+    std::vector<int> before;
+    std::vector<bool> reached(count, false);
+    for (uint64_t key = 0; key < 20 * count; ++key) {
+        before.push_back(batch.next_for_key(key));
+        reached[before.back()] = true;
+    }
+    EXPECT_EQ(std::count(reached.begin(), reached.end(), false), 0);
+    batch.add(count);
+    for (uint64_t key = 0; key < 20 * count; ++key) {
+        int owner = batch.next_for_key(key);
+        if (owner != before[key]) {
+            EXPECT_EQ(owner, count);
+        }
+    }
+}
+
+TEST(AffinityTest, MoveAndSwapCarryIndex) {
+    KeyedRoundRobin<rr::VectorStorage> a;
+    for (int i = 0; i < 8; ++i) {
+        a.add(i);
+    }
+    int owner = a.next_for_key(12345);
+
+    KeyedRoundRobin<rr::VectorStorage> b(std::move(a));
+    EXPECT_EQ(b.next_for_key(12345), owner);
+    EXPECT_EQ(a.try_next_for_key(12345), nullptr);
+
+    a.add(100);
+    swap(a, b);
+    EXPECT_EQ(a.next_for_key(12345), owner);
+    EXPECT_EQ(b.next_for_key(12345), 100);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include "round_robin/concurrent_round_robin.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef ROUND_ROBIN_HAS_COROUTINES
+
+#include <coroutine>
+
+namespace {
+
+// Minimal eagerly started coroutine that nobody awaits
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+Detached take_one(rr::ConcurrentRoundRobin<std::string>& pool, std::vector<std::string>& out) {
+    auto ref = co_await pool.async_next();
+    out.push_back(*ref);
+}
+
+// Takes an item, then writes to the pool from inside the resumed coroutine
+Detached take_then_add(rr::ConcurrentRoundRobin<std::string>& pool, std::vector<std::string>& out) {
+    auto ref = co_await pool.async_next();
+    out.push_back(*ref);
+    ref.reset();
+    pool.add("more");
+}
+
+Detached take_then_clear(rr::ConcurrentRoundRobin<std::string>& pool, std::vector<std::string>& out) {
+    auto ref = co_await pool.async_next();
+    out.push_back(*ref);
+    ref.reset();
+    pool.remove_if([](const std::string&) { return true; });
+}
+
+} // namespace
+
+TEST(AsyncNextTest, CompletesWithoutSuspendingWhenNotEmpty) {
+    rr::ConcurrentRoundRobin<std::string> pool;
+    pool.add("A");
+    pool.add("B");
+    std::vector<std::string> out;
+    take_one(pool, out);
+    take_one(pool, out);
+    EXPECT_EQ(out, (std::vector<std::string>{"A", "B"}));
+}
+
+TEST(AsyncNextTest, ResumedByAdd) {
+    rr::ConcurrentRoundRobin<std::string> pool;
+    std::vector<std::string> out;
+    take_one(pool, out);
+    take_one(pool, out);
+    EXPECT_TRUE(out.empty());
+
+    pool.add("A");
+    // Both coroutines were resumed inside add(), each with an item
+    EXPECT_EQ(out.size(), 2u);
+    EXPECT_EQ(out[0], "A");
+    EXPECT_EQ(out[1], "A");
+
+    // Later adds find no waiter
+    pool.add("B");
+    EXPECT_EQ(out.size(), 2u);
+}
+
+TEST(AsyncNextTest, ResumedByAssignFromAnotherThread) {
+    rr::ConcurrentRoundRobin<std::string> pool;
+    std::vector<std::string> out;
+    take_one(pool, out);
+
+    std::vector<std::string> backends{"X", "Y"};
+    std::thread writer([&] { pool.assign(backends.begin(), backends.end()); });
+    writer.join();
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0], "X");
+}
+
+TEST(AsyncNextTest, ResumedCoroutineMayWrite) {
+    rr::ConcurrentRoundRobin<std::string> pool;
+    std::vector<std::string> out;
+    take_one(pool, out);
+    take_then_add(pool, out); // Parked last, so resumed first
+
+    pool.add("A");
+    ASSERT_EQ(out.size(), 2u);
+    EXPECT_EQ(out[0], "A");
+    EXPECT_EQ(pool.size(), 2u);
+}
+
+TEST(AsyncNextTest, WaiterParksAgainWhenEmptiedBeforeItsTurn) {
+    rr::ConcurrentRoundRobin<std::string> pool;
+    std::vector<std::string> out;
+    take_one(pool, out);
+    take_then_clear(pool, out); // Resumed first, empties the pool
+
+    pool.add("A");
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(out[0], "A");
+    EXPECT_TRUE(pool.empty());
+
+    pool.add("B");
+    ASSERT_EQ(out.size(), 2u);
+    EXPECT_EQ(out[1], "B");
+}
+
+TEST(AsyncNextTest, MixedWithBlockingAcquire) {
+    rr::ConcurrentRoundRobin<std::string> pool;
+    std::vector<std::string> out;
+    std::atomic<bool> acquired{false};
+    std::thread blocked([&] {
+        acquired = static_cast<bool>(pool.acquire(std::chrono::seconds(10)));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    take_one(pool, out);
+
+    pool.add("A");
+    blocked.join();
+    EXPECT_TRUE(acquired);
+    EXPECT_EQ(out.size(), 1u);
+}
+
+#else
+
+TEST(AsyncNextTest, CoroutinesUnavailable) {
+    GTEST_SKIP() << "Compiler without C++20 coroutine support";
+}
+
+#endif
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 #include "round_robin/round_robin.hpp"
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -108,6 +112,105 @@ TEST_F(RoundRobinTest, SingleItem) {
     EXPECT_EQ(single.next(), "only");
 }
 
+TEST_F(RoundRobinTest, AddMidCycleIsVisitedInSameCycle) {
+    EXPECT_EQ(str_rr.next(), "third");
+    str_rr.add("fourth");
+    EXPECT_EQ(str_rr.next(), "fourth");
+    EXPECT_EQ(str_rr.next(), "second");
+    EXPECT_EQ(str_rr.next(), "first");
+
+    // Next cycle visits every item exactly once
+    std::set<std::string> cycle;
+    for (int i = 0; i < 4; ++i) {
+        cycle.insert(str_rr.next());
+    }
+    EXPECT_EQ(cycle.size(), 4);
+}
+
+TEST_F(RoundRobinTest, RemoveMidCycleContinuesWithNextItem) {
+    EXPECT_EQ(str_rr.next(), "third");
+    EXPECT_EQ(str_rr.next(), "second");
+    str_rr.remove_current();
+    EXPECT_EQ(str_rr.next(), "first");
+    EXPECT_EQ(str_rr.next(), "third");
+    EXPECT_EQ(str_rr.next(), "first");
+}
+
+TEST_F(RoundRobinTest, RemoveCurrentRequiresCurrentItem) {
+    EXPECT_THROW(str_rr.remove_current(), std::runtime_error);
+    str_rr.next();
+    str_rr.remove_current();
+    EXPECT_THROW(str_rr.remove_current(), std::runtime_error);
+    EXPECT_EQ(str_rr.size(), 2);
+}
+
+TEST_F(RoundRobinTest, LargeRotationVisitsEveryItemOncePerCycle) {
+    rr::RoundRobin<int> large;
+    const int n = 10000;
+    for (int i = 0; i < n; ++i) {
+        large.add(i);
+    }
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        std::vector<int> seen(n, 0);
+        for (int i = 0; i < n; ++i) {
+            ++seen[large.next()];
+        }
+        EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), n);
+    }
+}
+
+TEST_F(RoundRobinTest, AddRangePreservesOrder) {
+    rr::RoundRobin<std::string> rr;
+    std::vector<std::string> endpoints{"a", "b", "c", "d"};
+    rr.add_range(endpoints.begin(), endpoints.end());
+    EXPECT_EQ(rr.size(), 4);
+    for (const auto& endpoint : endpoints) {
+        EXPECT_EQ(rr.next(), endpoint);
+    }
+    EXPECT_EQ(rr.next(), "a");
+}
+
+TEST_F(RoundRobinTest, AddRangeMidCycleIsReturnedNext) {
+    EXPECT_EQ(str_rr.next(), "third");
+    std::vector<std::string> more{"x", "y"};
+    str_rr.add_range(more.begin(), more.end());
+    EXPECT_EQ(str_rr.next(), "x");
+    EXPECT_EQ(str_rr.next(), "y");
+    EXPECT_EQ(str_rr.next(), "second");
+    EXPECT_EQ(str_rr.next(), "first");
+}
+
+TEST_F(RoundRobinTest, AddRangeMovesItems) {
+    rr::RoundRobin<std::unique_ptr<int>> rr;
+    std::vector<std::unique_ptr<int>> items;
+    items.push_back(std::make_unique<int>(1));
+    items.push_back(std::make_unique<int>(2));
+    rr.add_range(std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+    EXPECT_EQ(*rr.next(), 1);
+    EXPECT_EQ(*rr.next(), 2);
+    EXPECT_EQ(items[0], nullptr);
+}
+
+// A type that can be neither copied nor moved
+struct Pinned {
+    explicit Pinned(int v, std::string n) : value(v), name(std::move(n)) {}
+    Pinned(const Pinned&) = delete;
+    Pinned& operator=(const Pinned&) = delete;
+    int value;
+    std::string name;
+};
+
+TEST_F(RoundRobinTest, EmplaceNonMovableType) {
+    rr::RoundRobin<Pinned> rr;
+    Pinned& first = rr.emplace(1, "one");
+    rr.emplace(2, "two");
+    EXPECT_EQ(first.value, 1);
+    EXPECT_EQ(rr.next().name, "two");
+    EXPECT_EQ(rr.next().name, "one");
+    rr.remove_current();
+    EXPECT_EQ(rr.size(), 1);
+}
+
 // won't compile
 // TEST(RoundRobinTest, CopyConstructorIsDeleted) {
 //     rr::RoundRobin<int> rr1;
@@ -0,0 +1,564 @@
+#include <gtest/gtest.h>
+#include "round_robin/concurrent_round_robin.hpp"
+#include "round_robin/sharded_round_robin.hpp"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(ConcurrentRoundRobinTest, EmptyContainer) {
+    rr::ConcurrentRoundRobin<int> rr;
+    EXPECT_TRUE(rr.empty());
+    EXPECT_FALSE(rr.try_next());
+    EXPECT_THROW(rr.next(), std::runtime_error);
+}
+
+TEST(ConcurrentRoundRobinTest, SingleThreadRotation) {
+    rr::ConcurrentRoundRobin<std::string> rr;
+    rr.add("A");
+    rr.add("B");
+    rr.add("C");
+    EXPECT_EQ(rr.size(), 3);
+    EXPECT_EQ(*rr.next(), "A");
+    EXPECT_EQ(*rr.next(), "B");
+    EXPECT_EQ(*rr.next(), "C");
+    EXPECT_EQ(*rr.next(), "A");
+}
+
+TEST(ConcurrentRoundRobinTest, RemoveIf) {
+    rr::ConcurrentRoundRobin<int> rr;
+    for (int i = 0; i < 10; ++i) {
+        rr.add(i);
+    }
+    EXPECT_EQ(rr.remove_if([](int v) { return v % 2 == 0; }), 5);
+    EXPECT_EQ(rr.size(), 5);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(*rr.next() % 2, 1);
+    }
+}
+
+TEST(ConcurrentRoundRobinTest, RefOutlivesRemoval) {
+    rr::ConcurrentRoundRobin<std::unique_ptr<int>> rr;
+    rr.add(std::make_unique<int>(42));
+    std::thread remover;
+    std::atomic<bool> removed{false};
+    {
+        auto ref = rr.next();
+        remover = std::thread([&] {
+            rr.remove_if([](const std::unique_ptr<int>&) { return true; });
+            removed = true;
+        });
+        // The remover waits for this Ref, so the item stays valid
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_FALSE(removed);
+        EXPECT_EQ(**ref, 42);
+    }
+    remover.join();
+    EXPECT_TRUE(removed);
+    EXPECT_TRUE(rr.empty());
+}
+
+TEST(ConcurrentRoundRobinTest, BatchIsConsecutive) {
+    rr::ConcurrentRoundRobin<int> rr;
+    EXPECT_EQ(rr.for_each_next(4, [](int&) { FAIL(); }), 0u);
+    for (int i = 0; i < 5; ++i) {
+        rr.add(i);
+    }
+    rr.next();
+    std::vector<int> batch;
+    EXPECT_EQ(rr.for_each_next(7, [&](int& item) { batch.push_back(item); }), 7u);
+    EXPECT_EQ(batch, (std::vector<int>{1, 2, 3, 4, 0, 1, 2}));
+    EXPECT_EQ(*rr.next(), 3);
+}
+
+TEST(ConcurrentRoundRobinTest, AddRangeAndAssign) {
+    rr::ConcurrentRoundRobin<int> rr;
+    std::vector<int> first{0, 1, 2};
+    rr.add_range(first.begin(), first.end());
+    EXPECT_EQ(rr.size(), 3);
+    EXPECT_EQ(*rr.next(), 0);
+
+    std::vector<int> replacement{10, 11, 12, 13};
+    rr.assign(replacement.begin(), replacement.end());
+    EXPECT_EQ(rr.size(), 4);
+    // The rotation keeps its position across the swap
+    EXPECT_EQ(*rr.next(), 11);
+    EXPECT_EQ(*rr.next(), 12);
+
+    rr.assign(first.end(), first.end());
+    EXPECT_TRUE(rr.empty());
+    EXPECT_FALSE(rr.try_next());
+}
+
+TEST(ConcurrentRoundRobinTest, MoveKeepsItemsAndPosition) {
+    rr::ConcurrentRoundRobin<std::string> rr;
+    rr.add("A");
+    rr.add("B");
+    rr.add("C");
+    EXPECT_EQ(*rr.next(), "A");
+
+    rr::ConcurrentRoundRobin<std::string> moved(std::move(rr));
+    EXPECT_TRUE(rr.empty());
+    EXPECT_FALSE(rr.try_next());
+    EXPECT_EQ(moved.size(), 3);
+    EXPECT_EQ(*moved.next(), "B");
+
+    rr::ConcurrentRoundRobin<std::string> assigned;
+    assigned.add("X");
+    assigned = std::move(moved);
+    EXPECT_TRUE(moved.empty());
+    EXPECT_EQ(*assigned.next(), "C");
+    EXPECT_EQ(*assigned.next(), "A");
+
+    // Moved-from containers remain usable
+    moved.add("D");
+    EXPECT_EQ(*moved.next(), "D");
+}
+
+// Readers see the old pool or the new one, never a mix
+TEST(ConcurrentRoundRobinTest, AssignIsAtomicForReaders) {
+    rr::ConcurrentRoundRobin<int> rr;
+    std::vector<int> evens(8, 0);
+    std::vector<int> odds(8, 1);
+    rr.assign(evens.begin(), evens.end());
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> mixed{false};
+    std::thread reader([&] {
+        while (!stop) {
+            int parity = -1;
+            rr.for_each_next(8, [&](int& item) {
+                if (parity != -1 && parity != item) {
+                    mixed = true;
+                }
+                parity = item;
+            });
+        }
+    });
+    for (int i = 0; i < 200; ++i) {
+        auto& next = i % 2 ? evens : odds;
+        rr.assign(next.begin(), next.end());
+    }
+    stop = true;
+    reader.join();
+    EXPECT_FALSE(mixed);
+}
+
+TEST(ConcurrentRoundRobinTest, AcquireReturnsAtOnceWhenNotEmpty) {
+    rr::ConcurrentRoundRobin<int> rr;
+    rr.add(1);
+    auto ref = rr.acquire(std::chrono::hours(1));
+    ASSERT_TRUE(ref);
+    EXPECT_EQ(*ref, 1);
+}
+
+TEST(ConcurrentRoundRobinTest, AcquireTimesOut) {
+    rr::ConcurrentRoundRobin<int> rr;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(rr.acquire(std::chrono::milliseconds(20)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+}
+
+TEST(ConcurrentRoundRobinTest, AcquireWakesOnAdd) {
+    rr::ConcurrentRoundRobin<int> rr;
+    std::atomic<int> served{0};
+    std::vector<std::thread> waiters;
+    for (int t = 0; t < 4; ++t) {
+        waiters.emplace_back([&] {
+            if (auto ref = rr.acquire(std::chrono::seconds(10))) {
+                EXPECT_EQ(*ref, 7);
+                ++served;
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(served.load(), 0);
+
+    // One add serves every waiter, since selection does not consume the item
+    auto start = std::chrono::steady_clock::now();
+    rr.add(7);
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    EXPECT_EQ(served.load(), 4);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(ConcurrentRoundRobinTest, AcquireRacingWithAddAndRemove) {
+    rr::ConcurrentRoundRobin<int> rr;
+    std::atomic<bool> stop{false};
+    std::atomic<int> served{0};
+    std::vector<std::thread> waiters;
+    for (int t = 0; t < 3; ++t) {
+        waiters.emplace_back([&] {
+            while (!stop) {
+                if (auto ref = rr.acquire(std::chrono::milliseconds(5))) {
+                    ++served;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 200; ++i) {
+        rr.add(i);
+        rr.remove_if([](int) { return true; });
+    }
+    stop = true;
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    EXPECT_TRUE(rr.empty());
+}
+
+// Batches reserve their tickets atomically, so mixing batch sizes across
+// threads still gives every item the same share.
+TEST(ConcurrentRoundRobinTest, BatchFairUnderContention) {
+    const int numItems = 5;
+    const int numThreads = 4;
+    const int batches = 500;
+
+    rr::ConcurrentRoundRobin<int> rr;
+    for (int i = 0; i < numItems; ++i) {
+        rr.add(i);
+    }
+
+    std::vector<std::vector<int>> counts(numThreads, std::vector<int>(numItems, 0));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t] {
+            // Batch sizes 5 and 10 keep the total a multiple of numItems
+            for (int i = 0; i < batches; ++i) {
+                rr.for_each_next((t % 2 + 1) * numItems, [&](int& item) { ++counts[t][item]; });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int item = 0; item < numItems; ++item) {
+        int total = 0;
+        for (int t = 0; t < numThreads; ++t) {
+            total += counts[t][item];
+        }
+        EXPECT_EQ(total, batches * (1 + 2 + 1 + 2));
+    }
+}
+
+// With a stable item set every item is selected the same number of times,
+// however the selections are spread across threads.
+TEST(ConcurrentRoundRobinTest, FairUnderContention) {
+    const int numItems = 7;
+    const int numThreads = 8;
+    const int perThread = numItems * 1000;
+
+    rr::ConcurrentRoundRobin<int> rr;
+    for (int i = 0; i < numItems; ++i) {
+        rr.add(i);
+    }
+
+    std::vector<std::vector<int>> counts(numThreads, std::vector<int>(numItems, 0));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < perThread; ++i) {
+                ++counts[t][*rr.next()];
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int item = 0; item < numItems; ++item) {
+        int total = 0;
+        for (int t = 0; t < numThreads; ++t) {
+            total += counts[t][item];
+        }
+        EXPECT_EQ(total, numThreads * perThread / numItems);
+    }
+}
+
+TEST(ConcurrentRoundRobinTest, LeastLoadedRotatesWhenIdle) {
+    rr::ConcurrentRoundRobin<int> rr;
+    EXPECT_FALSE(rr.try_next_least_loaded());
+    EXPECT_THROW(rr.next_least_loaded(), std::runtime_error);
+    for (int i = 0; i < 4; ++i) {
+        rr.add(i);
+    }
+    // With every item idle, ties go to the rotation
+    for (int i = 0; i < 8; ++i) {
+        auto pick = rr.next_least_loaded();
+        EXPECT_EQ(*pick, i % 4);
+        EXPECT_EQ(pick.in_flight(), 1u);
+    }
+}
+
+TEST(ConcurrentRoundRobinTest, LeastLoadedSkipsBusyItem) {
+    rr::ConcurrentRoundRobin<int> rr;
+    rr.add(0);
+    rr.add(1);
+    std::vector<rr::ConcurrentRoundRobin<int>::InFlight> stalled;
+    stalled.push_back(rr.next_least_loaded());
+    ASSERT_EQ(*stalled.back(), 0);
+
+    // While item 0 is busy, two candidates out of two always include item 1
+    for (int i = 0; i < 10; ++i) {
+        auto pick = rr.next_least_loaded();
+        EXPECT_EQ(*pick, 1);
+    }
+
+    // Once its request completes, item 0 is back in the rotation
+    stalled.back().complete();
+    EXPECT_FALSE(stalled.back());
+    int zeros = 0;
+    for (int i = 0; i < 10; ++i) {
+        zeros += *rr.next_least_loaded() == 0;
+    }
+    EXPECT_EQ(zeros, 5);
+}
+
+TEST(ConcurrentRoundRobinTest, InFlightOutlivesRemovalWithoutBlocking) {
+    rr::ConcurrentRoundRobin<std::unique_ptr<int>> rr;
+    rr.add(std::make_unique<int>(42));
+    auto pick = rr.next_least_loaded();
+    // Unlike a Ref, the guard does not hold up the writer
+    EXPECT_EQ(rr.remove_if([](const std::unique_ptr<int>&) { return true; }), 1u);
+    EXPECT_TRUE(rr.empty());
+    EXPECT_EQ(**pick, 42);
+    pick.complete();
+    EXPECT_EQ(pick.get(), nullptr);
+}
+
+// Workers finish requests on item 0 ten times slower than on the others;
+// load-aware selection should route most work away from it.
+TEST(ConcurrentRoundRobinTest, LeastLoadedFavorsFastItems) {
+    rr::ConcurrentRoundRobin<int> rr;
+    for (int i = 0; i < 4; ++i) {
+        rr.add(i);
+    }
+    std::atomic<size_t> counts[4] = {};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 200; ++i) {
+                auto pick = rr.next_least_loaded();
+                ++counts[*pick];
+                std::this_thread::sleep_for(std::chrono::microseconds(*pick == 0 ? 1000 : 100));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_LT(counts[0].load(), counts[1].load());
+    EXPECT_LT(counts[0].load(), 800u / 4);
+}
+
+// Readers rotate while writers add and remove items. Run under
+// ThreadSanitizer with -DENABLE_TSAN=ON.
+TEST(ConcurrentRoundRobinTest, StressReadersAndWriters) {
+    rr::ConcurrentRoundRobin<std::string> rr;
+    rr.add("base");
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> selections{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            while (!stop) {
+                auto ref = rr.try_next();
+                if (ref) {
+                    EXPECT_FALSE(ref->empty());
+                    ++selections;
+                }
+            }
+        });
+    }
+
+    std::thread writer([&] {
+        for (int i = 0; i < 60; ++i) {
+            rr.add("item" + std::to_string(i));
+            if (i % 3 == 0) {
+                rr.remove_if([&](const std::string& s) {
+                    return s == "item" + std::to_string(i / 2);
+                });
+            }
+        }
+    });
+
+    writer.join();
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_GT(selections.load(), 0u);
+    std::map<std::string, int> seen;
+    for (size_t i = 0; i < rr.size(); ++i) {
+        ++seen[*rr.next()];
+    }
+    EXPECT_EQ(seen.size(), rr.size());
+    EXPECT_EQ(seen.count("base"), 1);
+}
+
+TEST(ShardedRoundRobinTest, EmptyContainer) {
+    rr::ShardedRoundRobin<int> rr(4);
+    EXPECT_TRUE(rr.empty());
+    EXPECT_FALSE(rr.try_next());
+    EXPECT_THROW(rr.next(), std::runtime_error);
+    EXPECT_EQ(rr.for_each_next(3, [](int&) {}), 0u);
+}
+
+TEST(ShardedRoundRobinTest, SingleShardRotation) {
+    rr::ShardedRoundRobin<std::string> rr(1);
+    rr.add("A");
+    rr.add("B");
+    std::vector<std::string> cycle;
+    for (int i = 0; i < 4; ++i) {
+        cycle.push_back(*rr.next());
+    }
+    EXPECT_EQ(cycle[0], cycle[2]);
+    EXPECT_EQ(cycle[1], cycle[3]);
+    EXPECT_NE(cycle[0], cycle[1]);
+}
+
+// Draining the home shard makes it steal from the others, so a single
+// thread can still reach every item.
+TEST(ShardedRoundRobinTest, StealsWhenHomeShardIsEmpty) {
+    rr::ShardedRoundRobin<std::unique_ptr<int>> rr(4);
+    for (int i = 0; i < 20; ++i) {
+        rr.add(std::make_unique<int>(i));
+    }
+    EXPECT_EQ(rr.size(), 20);
+
+    std::vector<int> removed;
+    while (auto ref = rr.try_next()) {
+        removed.push_back(**ref);
+        ref.remove();
+    }
+    std::sort(removed.begin(), removed.end());
+    ASSERT_EQ(removed.size(), 20u);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(removed[i], i);
+    }
+    EXPECT_TRUE(rr.empty());
+}
+
+TEST(ShardedRoundRobinTest, StealsAcrossManyEmptyShards) {
+    // More shards than fit in one mask word, most of them empty
+    rr::ShardedRoundRobin<int> rr(200);
+    for (int i = 0; i < 150; ++i) {
+        rr.add(i);
+    }
+    EXPECT_FALSE(rr.empty());
+
+    std::vector<int> drained;
+    std::thread other([&] {
+        while (auto ref = rr.try_next()) {
+            drained.push_back(*ref);
+            ref.remove();
+        }
+    });
+    other.join();
+    std::sort(drained.begin(), drained.end());
+    ASSERT_EQ(drained.size(), 150u);
+    EXPECT_EQ(std::adjacent_find(drained.begin(), drained.end()), drained.end());
+    EXPECT_TRUE(rr.empty());
+    EXPECT_FALSE(rr.try_next());
+
+    rr.add(7);
+    EXPECT_FALSE(rr.empty());
+    EXPECT_EQ(rr.remove_if([](const int&) { return true; }), 1u);
+    EXPECT_TRUE(rr.empty());
+}
+
+TEST(ShardedRoundRobinTest, RemoveIf) {
+    rr::ShardedRoundRobin<int> rr(3);
+    for (int i = 0; i < 10; ++i) {
+        rr.add(i);
+    }
+    EXPECT_EQ(rr.remove_if([](int v) { return v % 2 == 0; }), 5);
+    EXPECT_EQ(rr.size(), 5);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(*rr.next() % 2, 1);
+    }
+}
+
+// One thread per shard and equal shard sizes: every item is selected at the
+// same rate.
+TEST(ShardedRoundRobinTest, FairUnderContention) {
+    const int numThreads = 4;
+    const int numItems = 16;
+    const int perThread = 4000;
+
+    rr::ShardedRoundRobin<int> rr(numThreads);
+    for (int i = 0; i < numItems; ++i) {
+        rr.add(i);
+    }
+
+    std::vector<std::vector<int>> counts(numThreads, std::vector<int>(numItems, 0));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < perThread / 4; ++i) {
+                ++counts[t][*rr.next()];
+            }
+            rr.for_each_next(perThread - perThread / 4, [&](int& item) { ++counts[t][item]; });
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int item = 0; item < numItems; ++item) {
+        int total = 0;
+        for (int t = 0; t < numThreads; ++t) {
+            total += counts[t][item];
+        }
+        EXPECT_EQ(total, numThreads * perThread / numItems);
+    }
+}
+
+// Selections, removals and additions from many threads; every item added is
+// either still stored or was removed exactly once.
+TEST(ShardedRoundRobinTest, StressWithStealing) {
+    rr::ShardedRoundRobin<int> rr(4);
+    std::atomic<int> next_value{0};
+    std::atomic<int> removed{0};
+    for (int i = 0; i < 32; ++i) {
+        rr.add(next_value++);
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 6; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 2000; ++i) {
+                if (auto ref = rr.try_next()) {
+                    if ((*ref + i + t) % 5 == 0) {
+                        ref.remove();
+                        ++removed;
+                    }
+                }
+                if (i % 7 == 0) {
+                    rr.add(next_value++);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(rr.size(), static_cast<size_t>(next_value - removed));
+    std::vector<int> remaining;
+    while (auto ref = rr.try_next()) {
+        remaining.push_back(*ref);
+        ref.remove();
+    }
+    std::sort(remaining.begin(), remaining.end());
+    EXPECT_EQ(std::adjacent_find(remaining.begin(), remaining.end()), remaining.end());
+    EXPECT_EQ(remaining.size(), static_cast<size_t>(next_value - removed));
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "round_robin/fair_queue.hpp"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+size_t allocations = 0;
+
+/** Counts every allocation made through it, so tests can check steady state. */
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        ++allocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+} // namespace
+
+TEST(FairQueueTest, InterleavesKeys) {
+    rr::FairQueue<std::string, int> queue;
+    for (int i = 0; i < 3; ++i) {
+        queue.push("a", i);
+    }
+    queue.push("b", 10);
+    queue.push("c", 20);
+    queue.push("c", 21);
+
+    std::vector<int> order;
+    while (auto task = queue.try_pop()) {
+        order.push_back(*task);
+    }
+    EXPECT_EQ(order, (std::vector<int>{0, 10, 20, 1, 21, 2}));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(FairQueueTest, OnlyKeysWithWorkRotate) {
+    rr::FairQueue<int, int> queue;
+    queue.push(1, 1);
+    queue.push(2, 2);
+    EXPECT_EQ(queue.active_keys(), 2u);
+
+    EXPECT_EQ(queue.pop(), 1);
+    EXPECT_EQ(queue.active_keys(), 1u);
+    EXPECT_EQ(queue.key_count(), 2u);
+
+    // A key that gets work again rejoins the current round
+    queue.push(1, 3);
+    EXPECT_EQ(queue.pop(), 2);
+    EXPECT_EQ(queue.pop(), 3);
+    EXPECT_EQ(queue.active_keys(), 0u);
+    EXPECT_EQ(queue.try_pop(), std::nullopt);
+    EXPECT_THROW(queue.pop(), std::runtime_error);
+}
+
+TEST(FairQueueTest, KeepsFifoOrderAcrossGrowth) {
+    rr::FairQueue<int, int> queue;
+    // Pop some first so the ring wraps before it grows
+    for (int i = 0; i < 5; ++i) {
+        queue.push(0, i);
+    }
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(queue.pop(), i);
+    }
+    for (int i = 5; i < 100; ++i) {
+        queue.push(0, i);
+    }
+    const auto& view = queue;
+    EXPECT_EQ(view.size(0), 97u);
+    EXPECT_EQ(view.size(1), 0u);
+    for (int i = 3; i < 100; ++i) {
+        EXPECT_EQ(queue.pop(), i);
+    }
+}
+
+TEST(FairQueueTest, EraseDropsTasks) {
+    rr::FairQueue<int, std::unique_ptr<int>> queue;
+    queue.push(1, std::make_unique<int>(1));
+    queue.push(1, std::make_unique<int>(2));
+    queue.push(2, std::make_unique<int>(3));
+
+    EXPECT_EQ(queue.erase(1), 2u);
+    EXPECT_EQ(queue.erase(1), 0u);
+    EXPECT_EQ(queue.size(), 1u);
+    EXPECT_EQ(queue.key_count(), 1u);
+    EXPECT_EQ(*queue.pop(), 3);
+}
+
+TEST(FairQueueTest, SteadyStateDoesNotAllocate) {
+    rr::FairQueue<int, int, std::hash<int>, std::equal_to<int>, CountingAllocator<int>> queue;
+    auto round = [&queue] {
+        for (int key = 0; key < 16; ++key) {
+            for (int i = 0; i < key; ++i) {
+                queue.push(key, i);
+            }
+        }
+        while (queue.try_pop()) {
+        }
+    };
+
+    round();
+    size_t warmed_up = allocations;
+    for (int i = 0; i < 10; ++i) {
+        round();
+    }
+    EXPECT_EQ(allocations, warmed_up);
+    EXPECT_EQ(queue.key_count(), 15u);
+}
@@ -0,0 +1,387 @@
+#include <gtest/gtest.h>
+#include "round_robin/round_robin.hpp"
+#include "round_robin/concurrent_round_robin.hpp"
+#include "round_robin/sharded_round_robin.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fairness gates for every rotation mode. Each test drives millions of
+// selections, asserts bounds on how unevenly items were served and, where
+// there is a global order, on how often an item came up twice in one cycle,
+// then prints the mode's throughput. A faster hot path has to keep these green.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint64_t selections = 2'000'000;
+
+/**
+ * @brief Prints a mode's selection rate and records it in the test's XML output.
+ */
+void report(const std::string& mode, uint64_t count, Clock::duration elapsed) {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double rate = static_cast<double>(count) / std::max(seconds, 1e-9);
+    std::printf("[   RATE   ] %-44s %8.2f M selections/s\n", mode.c_str(), rate / 1e6);
+    ::testing::Test::RecordProperty("selections_per_second", std::to_string(static_cast<uint64_t>(rate)));
+}
+
+/**
+ * @brief Ratio of the largest to the smallest count; 1 when perfectly even.
+ */
+double spread(const std::vector<uint64_t>& counts) {
+    auto [low, high] = std::minmax_element(counts.begin(), counts.end());
+    return *low == 0 ? HUGE_VAL : static_cast<double>(*high) / static_cast<double>(*low);
+}
+
+/**
+ * @brief Counts selections that repeat an item within one cycle.
+ *
+ * The selection sequence is cut into consecutive windows of `cycle`
+ * selections; every selection of an item already seen in its window is a
+ * duplicate. A strict rotation over a stable set has none.
+ */
+class CycleTracker {
+private:
+    size_t cycle_;
+    uint64_t window_ = 1;
+    size_t position_ = 0;
+    std::vector<uint64_t> seen_in_; ///< Window in which each item was last seen.
+
+public:
+    uint64_t duplicates = 0;
+    uint64_t total = 0;
+
+    explicit CycleTracker(size_t cycle) : cycle_(cycle) {}
+
+    void record(size_t item) {
+        if (item >= seen_in_.size()) {
+            seen_in_.resize(item + 1, 0);
+        }
+        duplicates += seen_in_[item] == window_;
+        seen_in_[item] = window_;
+        ++total;
+        if (++position_ == cycle_) {
+            position_ = 0;
+            ++window_;
+        }
+    }
+
+    double rate() const {
+        return total == 0 ? 0.0 : static_cast<double>(duplicates) / static_cast<double>(total);
+    }
+};
+
+/**
+ * @brief A RoundRobin configuration under test.
+ * @tparam Container The RoundRobin instantiation; items are ints.
+ * @tparam Charged Whether each selection must be charged (DeficitStorage), 1 unit each.
+ */
+template<typename Container, bool Charged = false>
+struct Mode {
+    using RR = Container;
+
+    static int select(RR& rr) {
+        int item = rr.next();
+        if constexpr (Charged) {
+            rr.charge_current(1);
+        }
+        return item;
+    }
+};
+
+struct ListMode : Mode<rr::RoundRobin<int, rr::ListStorage>> {
+    static constexpr const char* name = "RoundRobin<ListStorage>";
+};
+struct VectorMode : Mode<rr::RoundRobin<int, rr::VectorStorage>> {
+    static constexpr const char* name = "RoundRobin<VectorStorage>";
+};
+struct WeightedMode : Mode<rr::RoundRobin<int, rr::WeightedStorage>> {
+    static constexpr const char* name = "RoundRobin<WeightedStorage>";
+};
+struct DeficitMode : Mode<rr::RoundRobin<int, rr::DeficitStorage>, true> {
+    static constexpr const char* name = "RoundRobin<DeficitStorage>";
+};
+struct PooledMode : Mode<rr::PooledRoundRobin<int>> {
+    static constexpr const char* name = "PooledRoundRobin";
+};
+
+} // namespace
+
+template<typename M>
+class FairnessTest : public ::testing::Test {};
+
+using FairnessModes = ::testing::Types<ListMode, VectorMode, WeightedMode, DeficitMode, PooledMode>;
+TYPED_TEST_SUITE(FairnessTest, FairnessModes);
+
+// Small, medium and large stable sets: every item is served exactly once per cycle
+TYPED_TEST(FairnessTest, StableRotationIsExact) {
+    for (size_t n : {3u, 1000u, 100000u}) {
+        typename TypeParam::RR rr;
+        for (size_t i = 0; i < n; ++i) {
+            rr.add(static_cast<int>(i));
+        }
+        const uint64_t count = selections / n * n;
+
+        uint64_t sink = 0;
+        auto start = Clock::now();
+        for (uint64_t s = 0; s < count; ++s) {
+            sink += TypeParam::select(rr);
+        }
+        report(std::string(TypeParam::name) + " n=" + std::to_string(n), count, Clock::now() - start);
+        EXPECT_NE(sink, UINT64_MAX);
+
+        std::vector<uint64_t> counts(n);
+        CycleTracker cycles(n);
+        for (uint64_t s = 0; s < count; ++s) {
+            int item = TypeParam::select(rr);
+            ++counts[item];
+            cycles.record(item);
+        }
+        EXPECT_EQ(spread(counts), 1.0) << "n=" << n;
+        EXPECT_EQ(cycles.duplicates, 0u) << "n=" << n;
+    }
+}
+
+// Random removals and additions mid-rotation: each item's share of the
+// selections made while it was present stays close to 1/n
+TYPED_TEST(FairnessTest, ChurnKeepsSharesEven) {
+    constexpr size_t n = 1000;
+    constexpr uint64_t churn_every = 37;
+    typename TypeParam::RR pool;
+    std::vector<rr::Handle> live; // Handles of the items present, indexed arbitrarily
+    std::vector<uint64_t> joined; // Selection number at which each item was added
+    std::vector<uint64_t> counts;
+    std::vector<double> ratios;
+    auto add = [&](uint64_t now) {
+        int id = static_cast<int>(joined.size());
+        live.push_back(pool.add(id));
+        joined.push_back(now);
+        counts.push_back(0);
+    };
+    auto settle = [&](int id, uint64_t now) {
+        double due = static_cast<double>(now - joined[id]) / n;
+        if (due >= 50) {
+            ratios.push_back(static_cast<double>(counts[id]) / due);
+        }
+    };
+    for (size_t i = 0; i < n; ++i) {
+        add(0);
+    }
+
+    std::mt19937 random(7);
+    CycleTracker cycles(n);
+    auto start = Clock::now();
+    for (uint64_t s = 1; s <= selections; ++s) {
+        int item = TypeParam::select(pool);
+        ++counts[item];
+        cycles.record(item);
+        if (s % churn_every == 0) {
+            size_t victim = random() % live.size();
+            int id = *pool.get(live[victim]);
+            ASSERT_TRUE(pool.remove(live[victim]));
+            settle(id, s);
+            live[victim] = live.back();
+            live.pop_back();
+            add(s);
+        }
+    }
+    report(std::string(TypeParam::name) + " churn", selections, Clock::now() - start);
+    for (rr::Handle handle : live) {
+        settle(*pool.get(handle), selections);
+    }
+
+    ASSERT_GT(ratios.size(), 1000u);
+    auto [low, high] = std::minmax_element(ratios.begin(), ratios.end());
+    EXPECT_GT(*low, 0.95);
+    EXPECT_LT(*high, 1.05);
+    EXPECT_LT(cycles.rate(), 0.01);
+}
+
+// Items are served in proportion to their weights, exactly per full weight cycle
+TEST(FairnessTest, WeightsAreHonoured) {
+    rr::RoundRobin<int, rr::WeightedStorage> rr;
+    std::vector<unsigned> weights;
+    uint64_t total_weight = 0;
+    for (int i = 0; i < 800; ++i) {
+        weights.push_back(1 + i % 8);
+        total_weight += weights.back();
+        rr.add(i, weights.back());
+    }
+    const uint64_t count = selections / total_weight * total_weight;
+    std::vector<uint64_t> counts(weights.size());
+    auto start = Clock::now();
+    for (uint64_t s = 0; s < count; ++s) {
+        ++counts[rr.next()];
+    }
+    report("RoundRobin<WeightedStorage> weights 1-8", count, Clock::now() - start);
+
+    for (size_t i = 0; i < counts.size(); ++i) {
+        EXPECT_EQ(counts[i], count / total_weight * weights[i]) << "item " << i;
+    }
+}
+
+// A RoundRobin shared behind a mutex keeps one global order however many threads take part
+TEST(FairnessTest, LockedRoundRobinAcrossThreads) {
+    constexpr size_t n = 1000;
+    for (size_t threads : {1u, 2u, 4u, 8u}) {
+        rr::RoundRobin<int, rr::VectorStorage> rr;
+        for (size_t i = 0; i < n; ++i) {
+            rr.add(static_cast<int>(i));
+        }
+        std::mutex mutex;
+        std::vector<uint64_t> counts(n);
+        CycleTracker cycles(n);
+        const uint64_t per_thread = selections / threads / n * n;
+
+        auto start = Clock::now();
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                for (uint64_t s = 0; s < per_thread; ++s) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    int item = rr.next();
+                    ++counts[item];
+                    cycles.record(item);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        report("mutex + RoundRobin threads=" + std::to_string(threads), per_thread * threads, Clock::now() - start);
+
+        EXPECT_EQ(spread(counts), 1.0) << "threads=" << threads;
+        EXPECT_EQ(cycles.duplicates, 0u) << "threads=" << threads;
+    }
+}
+
+// The shared ticket makes the aggregate exact: every item gets the same count
+TEST(FairnessTest, ConcurrentRoundRobinAcrossThreads) {
+    constexpr size_t n = 1000;
+    for (size_t threads : {1u, 2u, 4u, 8u}) {
+        rr::ConcurrentRoundRobin<int> rr;
+        for (size_t i = 0; i < n; ++i) {
+            rr.add(static_cast<int>(i));
+        }
+        std::vector<std::vector<uint64_t>> counts(threads, std::vector<uint64_t>(n));
+        const uint64_t per_thread = selections / threads / n * n;
+
+        auto start = Clock::now();
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                for (uint64_t s = 0; s < per_thread; ++s) {
+                    ++counts[t][*rr.next()];
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        report("ConcurrentRoundRobin threads=" + std::to_string(threads), per_thread * threads, Clock::now() - start);
+
+        std::vector<uint64_t> total(n);
+        for (const auto& thread_counts : counts) {
+            for (size_t i = 0; i < n; ++i) {
+                total[i] += thread_counts[i];
+            }
+        }
+        EXPECT_EQ(spread(total), 1.0) << "threads=" << threads;
+    }
+}
+
+// Each write can shift an item's phase in the rotation by at most one
+// selection per reader in flight, so permanent items stay within that bound
+TEST(FairnessTest, ConcurrentRoundRobinUnderChurn) {
+    constexpr size_t n = 1000;
+    constexpr size_t threads = 4;
+    constexpr int writes = 100;
+    rr::ConcurrentRoundRobin<int> rr;
+    for (size_t i = 0; i < n; ++i) {
+        rr.add(static_cast<int>(i));
+    }
+    std::vector<std::vector<uint64_t>> counts(threads, std::vector<uint64_t>(n));
+    const uint64_t per_thread = selections / threads;
+    std::atomic<size_t> finished{0};
+
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (uint64_t s = 0; s < per_thread; ++s) {
+                int item = *rr.next();
+                if (item < static_cast<int>(n)) {
+                    ++counts[t][item];
+                }
+            }
+            ++finished;
+        });
+    }
+    // Temporary items come and go while the readers run
+    int done = 0;
+    for (; done < writes && finished.load() < threads; ++done) {
+        int extra = static_cast<int>(n) + done;
+        rr.add(extra);
+        rr.remove_if([extra](int item) { return item >= static_cast<int>(n) && item < extra - 4; });
+        std::this_thread::yield();
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    report("ConcurrentRoundRobin threads=4 churn", per_thread * threads, Clock::now() - start);
+
+    std::vector<uint64_t> total(n);
+    for (const auto& thread_counts : counts) {
+        for (size_t i = 0; i < n; ++i) {
+            total[i] += thread_counts[i];
+        }
+    }
+    auto [low, high] = std::minmax_element(total.begin(), total.end());
+    EXPECT_GT(*low, 0u);
+    EXPECT_LE(*high - *low, static_cast<uint64_t>(2 * done + 1) * (threads + 1));
+}
+
+// With one thread per shard and balanced shards, every item is served equally
+TEST(FairnessTest, ShardedRoundRobinAcrossThreads) {
+    constexpr size_t n = 1024;
+    for (size_t threads : {1u, 2u, 4u, 8u}) {
+        rr::ShardedRoundRobin<int> rr(threads);
+        for (size_t i = 0; i < n; ++i) {
+            rr.add(static_cast<int>(i));
+        }
+        std::vector<std::vector<uint64_t>> counts(threads, std::vector<uint64_t>(n));
+        const uint64_t per_thread = selections / threads / (n / threads) * (n / threads);
+
+        auto start = Clock::now();
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                for (uint64_t s = 0; s < per_thread; ++s) {
+                    ++counts[t][*rr.next()];
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        report("ShardedRoundRobin threads=" + std::to_string(threads), per_thread * threads, Clock::now() - start);
+
+        std::vector<uint64_t> total(n);
+        for (const auto& thread_counts : counts) {
+            for (size_t i = 0; i < n; ++i) {
+                total[i] += thread_counts[i];
+            }
+        }
+        EXPECT_EQ(spread(total), 1.0) << "threads=" << threads;
+    }
+}
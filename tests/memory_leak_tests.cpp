@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "round_robin/round_robin.hpp"
+#include <memory>
+#include <string>
 
 TEST(RoundRobinTest, MoveSemanticNoLeak) {
     rr::RoundRobin<std::unique_ptr<int>> rr;
@@ -50,6 +52,85 @@ TEST(RoundRobinTest, MoveAssignmentNoLeak) {
     // No leak expected after move assignment and use
 }
 
+TEST(RoundRobinTest, PoolReturnsMemoryOnDestruction) {
+    rr::PoolAllocator<std::string> alloc;
+    {
+        rr::PooledRoundRobin<std::string> rr(alloc);
+        for (int i = 0; i < 1000; ++i) {
+            rr.add("item" + std::to_string(i));
+        }
+        ASSERT_EQ(alloc.resource().blocks_in_use(), 1000);
+
+        // Churn: every removal frees a node that the next add reuses
+        const size_t reserved = alloc.resource().bytes_reserved();
+        for (int i = 0; i < 10000; ++i) {
+            rr.next();
+            rr.remove_current();
+            rr.add("churn");
+        }
+        ASSERT_EQ(alloc.resource().bytes_reserved(), reserved);
+        ASSERT_EQ(alloc.resource().blocks_in_use(), 1000);
+    }
+    ASSERT_EQ(alloc.resource().blocks_in_use(), 0);
+    // The chunks themselves are freed with the last allocator copy; ASan
+    // reports them if they are not.
+}
+
+TEST(RoundRobinTest, PoolReturnsMemoryOnMoveAssignment) {
+    rr::PoolAllocator<std::unique_ptr<int>> alloc1;
+    rr::PoolAllocator<std::unique_ptr<int>> alloc2;
+
+    rr::PooledRoundRobin<std::unique_ptr<int>> rr1(alloc1);
+    rr::PooledRoundRobin<std::unique_ptr<int>> rr2(alloc2);
+    for (int i = 0; i < 100; ++i) {
+        rr1.add(std::make_unique<int>(i));
+        rr2.add(std::make_unique<int>(i));
+    }
+    ASSERT_EQ(alloc2.resource().blocks_in_use(), 100);
+
+    rr2 = std::move(rr1); // rr2's old nodes go back to its old pool
+    ASSERT_EQ(alloc2.resource().blocks_in_use(), 0);
+    ASSERT_EQ(alloc1.resource().blocks_in_use(), 100);
+    ASSERT_EQ(rr2.size(), 100);
+
+    while (!rr2.empty()) {
+        rr2.next();
+        rr2.remove_current();
+    }
+    ASSERT_EQ(alloc1.resource().blocks_in_use(), 0);
+}
+
+TEST(RoundRobinTest, PooledVectorStorageNoLeak) {
+    rr::PoolAllocator<int> alloc;
+    {
+        rr::PooledRoundRobin<int, rr::VectorStorage> rr(alloc);
+        for (int i = 0; i < 100; ++i) {
+            rr.add(i);
+        }
+        rr.next();
+        rr.remove_current();
+        ASSERT_EQ(rr.size(), 99);
+    }
+    ASSERT_EQ(alloc.resource().blocks_in_use(), 0);
+}
+
+TEST(RoundRobinTest, SuspendedItemsFreedOnDestruction) {
+    rr::PoolAllocator<std::unique_ptr<int>> alloc;
+    {
+        rr::PooledRoundRobin<std::unique_ptr<int>> rr(alloc);
+        for (int i = 0; i < 10; ++i) {
+            rr.add(std::make_unique<int>(i));
+        }
+        for (int i = 0; i < 5; ++i) {
+            rr.next();
+            rr.suspend_current(); // Suspending moves the node, it never copies or frees it
+        }
+        ASSERT_EQ(rr.suspended_count(), 5);
+        ASSERT_EQ(alloc.resource().blocks_in_use(), 10);
+    }
+    ASSERT_EQ(alloc.resource().blocks_in_use(), 0);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "round_robin/round_robin.hpp"
+#include "round_robin/static_round_robin.hpp"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Rotates a pool at compile time and returns the items of two cycles as digits
+constexpr int rotate_twice() {
+    rr::StaticRoundRobin<int, 3> pool{1, 2, 3};
+    int digits = 0;
+    for (size_t i = 0; i < 2 * pool.size(); ++i) {
+        digits = digits * 10 + pool.next();
+    }
+    return digits;
+}
+
+constexpr int remove_at_compile_time() {
+    rr::StaticRoundRobin<int, 4> pool{1, 2, 3, 4};
+    pool.next();
+    pool.remove_current(); // 4 takes the place of 1 and is due next
+    int digits = 0;
+    for (int i = 0; i < 3; ++i) {
+        digits = digits * 10 + pool.next();
+    }
+    return digits;
+}
+
+// Code written against the shared interface works with either container
+template<typename Pool>
+int drain(Pool& pool) {
+    int sum = 0;
+    while (!pool.empty()) {
+        sum += pool.next();
+        pool.remove_current();
+    }
+    return sum;
+}
+
+} // namespace
+
+static_assert(rotate_twice() == 123123, "constexpr rotation");
+static_assert(remove_at_compile_time() == 423, "constexpr removal");
+static_assert(rr::StaticRoundRobin<int, 8>::capacity() == 8, "capacity");
+
+TEST(StaticRoundRobinTest, EmptyContainer) {
+    rr::StaticRoundRobin<int, 4> pool;
+    EXPECT_TRUE(pool.empty());
+    EXPECT_EQ(pool.try_next(), nullptr);
+    EXPECT_THROW(pool.next(), std::runtime_error);
+    EXPECT_THROW(pool.remove_current(), std::runtime_error);
+}
+
+TEST(StaticRoundRobinTest, CapacityIsEnforced) {
+    rr::StaticRoundRobin<int, 2> pool;
+    pool.add(1);
+    pool.add(2);
+    EXPECT_TRUE(pool.full());
+    EXPECT_THROW(pool.add(3), std::length_error);
+    EXPECT_EQ(pool.size(), 2);
+}
+
+TEST(StaticRoundRobinTest, PowerOfTwoWrapsWithMask) {
+    rr::StaticRoundRobin<int, 4> pool{0, 1, 2, 3};
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(pool.next(), i % 4);
+    }
+}
+
+TEST(StaticRoundRobinTest, FillingUpMidCycle) {
+    rr::StaticRoundRobin<int, 4> pool{0, 1, 2};
+    EXPECT_EQ(pool.next(), 0);
+    EXPECT_EQ(pool.next(), 1);
+    EXPECT_EQ(pool.next(), 2);
+    pool.add(3); // Becomes full with the cursor at the end
+    EXPECT_EQ(pool.next(), 3);
+    EXPECT_EQ(pool.next(), 0);
+}
+
+TEST(StaticRoundRobinTest, RemovalKeepsCycleComplete) {
+    rr::StaticRoundRobin<int, 8> pool;
+    for (int i = 0; i < 8; ++i) {
+        pool.add(i);
+    }
+    std::vector<int> seen(8, 0);
+    for (int i = 0; i < 8; ++i) {
+        int value = pool.next();
+        ++seen[value];
+        if (value % 2 == 0) {
+            pool.remove_current();
+        }
+    }
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), 8);
+    EXPECT_EQ(pool.size(), 4);
+    EXPECT_THROW(pool.remove_current(), std::runtime_error);
+
+    std::vector<int> cycle;
+    for (int i = 0; i < 4; ++i) {
+        cycle.push_back(pool.next());
+    }
+    std::sort(cycle.begin(), cycle.end());
+    EXPECT_EQ(cycle, (std::vector<int>{1, 3, 5, 7}));
+}
+
+TEST(StaticRoundRobinTest, MoveOnlyItemsAreReleasedOnRemoval) {
+    auto shared = std::make_shared<int>(1);
+    rr::StaticRoundRobin<std::shared_ptr<int>, 2> pool;
+    pool.add(shared);
+    EXPECT_EQ(shared.use_count(), 2);
+    pool.next();
+    pool.remove_current();
+    EXPECT_EQ(shared.use_count(), 1);
+
+    rr::StaticRoundRobin<std::unique_ptr<std::string>, 2> owned;
+    owned.add(std::make_unique<std::string>("A"));
+    EXPECT_EQ(*owned.next(), "A");
+}
+
+TEST(StaticRoundRobinTest, InterchangeableWithRoundRobin) {
+    rr::StaticRoundRobin<int, 4> fixed{1, 2, 3, 4};
+    rr::RoundRobin<int> dynamic;
+    for (int i = 1; i <= 4; ++i) {
+        dynamic.add(i);
+    }
+    EXPECT_EQ(drain(fixed), 10);
+    EXPECT_EQ(drain(dynamic), 10);
+}
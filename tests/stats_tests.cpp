@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include "round_robin/round_robin.hpp"
+#include <atomic>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+template<typename RR>
+class StatsTest : public ::testing::Test {
+protected:
+    RR rr;
+};
+
+template<template<typename, typename> class Storage>
+using CountedRoundRobin = rr::RoundRobin<int, Storage, std::allocator<int>, rr::SelectionStats<>>;
+
+using StatsTypes = ::testing::Types<
+    CountedRoundRobin<rr::ListStorage>,
+    CountedRoundRobin<rr::VectorStorage>,
+    CountedRoundRobin<rr::WeightedStorage>>;
+TYPED_TEST_SUITE(StatsTest, StatsTypes);
+
+TYPED_TEST(StatsTest, CountsSelectionsPerItem) {
+    std::vector<rr::Handle> handles;
+    for (int i = 0; i < 5; ++i) {
+        handles.push_back(this->rr.add(i));
+    }
+    for (int i = 0; i < 50; ++i) {
+        this->rr.next();
+    }
+
+    auto stats = this->rr.stats();
+    EXPECT_EQ(stats.total_selections, 50u);
+    for (rr::Handle handle : handles) {
+        EXPECT_EQ(stats.selections_of(handle), 10u);
+    }
+    EXPECT_EQ(std::accumulate(stats.selections.begin(), stats.selections.end(), uint64_t{0}), 50u);
+}
+
+TYPED_TEST(StatsTest, BatchSelectionsAreCounted) {
+    rr::Handle a = this->rr.add(1);
+    rr::Handle b = this->rr.add(2);
+    int* out[6];
+    EXPECT_EQ(this->rr.next_n(out, 6), 6u);
+    EXPECT_EQ(this->rr.for_each_next(4, [](int&) {}), 4u);
+
+    auto stats = this->rr.stats();
+    EXPECT_EQ(stats.total_selections, 10u);
+    EXPECT_EQ(stats.selections_of(a), 5u);
+    EXPECT_EQ(stats.selections_of(b), 5u);
+}
+
+TYPED_TEST(StatsTest, RemovalResetsItemCount) {
+    rr::Handle a = this->rr.add(1);
+    rr::Handle b = this->rr.add(2);
+    rr::Handle c = this->rr.add(3);
+    for (int i = 0; i < 6; ++i) {
+        this->rr.next();
+    }
+    EXPECT_TRUE(this->rr.remove(a));
+    EXPECT_FALSE(this->rr.remove(a));
+    uint64_t selected = 6;
+    do {
+        ++selected;
+    } while (this->rr.next() != 2);
+    this->rr.remove_current();
+
+    auto stats = this->rr.stats();
+    EXPECT_EQ(stats.removals, 2u);
+    EXPECT_EQ(stats.selections_of(a), 0u);
+    EXPECT_EQ(stats.selections_of(b), 0u);
+    EXPECT_GE(stats.selections_of(c), 2u);
+    EXPECT_EQ(stats.total_selections, selected);
+}
+
+TYPED_TEST(StatsTest, EmptyContainerRecordsNothing) {
+    EXPECT_EQ(this->rr.try_next(), nullptr);
+    auto stats = this->rr.stats();
+    EXPECT_EQ(stats.total_selections, 0u);
+    EXPECT_TRUE(stats.selections.empty());
+}
+
+TEST(StatsTest, CountsCycles) {
+    CountedRoundRobin<rr::VectorStorage> rr;
+    for (int i = 0; i < 4; ++i) {
+        rr.add(i);
+    }
+    for (int i = 0; i < 4 * 3 + 1; ++i) {
+        rr.next();
+    }
+    // The first pass starts at the front; each later pass begins with a wrap
+    EXPECT_EQ(rr.stats().cycles, 3u);
+}
+
+TEST(StatsTest, WeightedCountsRounds) {
+    CountedRoundRobin<rr::WeightedStorage> rr;
+    rr.add(0, 1);
+    rr.add(1, 3);
+    for (int i = 0; i < 4 * 3 + 1; ++i) {
+        rr.next();
+    }
+    // A round serves each item once per unit of weight, like a cycle of a plain rotation
+    EXPECT_EQ(rr.stats().cycles, 3u);
+
+    // An item added mid-round neither restarts nor skips the count
+    rr.add(2, 4);
+    for (int i = 0; i < 8 * 2; ++i) {
+        rr.next();
+    }
+    EXPECT_EQ(rr.stats().cycles, 5u);
+}
+
+TEST(StatsTest, MoveCarriesCounters) {
+    CountedRoundRobin<rr::ListStorage> rr;
+    rr::Handle handle = rr.add(7);
+    rr.next();
+    rr.next();
+
+    CountedRoundRobin<rr::ListStorage> moved(std::move(rr));
+    EXPECT_EQ(moved.stats().selections_of(handle), 2u);
+    EXPECT_EQ(rr.stats().total_selections, 0u);
+}
+
+TEST(StatsTest, TimedHistogramCoversEverySelection) {
+    rr::RoundRobin<int, rr::VectorStorage, std::allocator<int>, rr::TimedSelectionStats> rr;
+    rr.try_next();
+    rr.add(1);
+    rr.add(2);
+    for (int i = 0; i < 100; ++i) {
+        rr.next();
+    }
+
+    auto stats = rr.stats();
+    EXPECT_EQ(stats.total_selections, 100u);
+    // Failed selections on an empty container are timed as well
+    EXPECT_EQ(std::accumulate(stats.selection_ns.begin(), stats.selection_ns.end(), uint64_t{0}), 101u);
+}
+
+TEST(StatsTest, SnapshotWhileRotating) {
+    CountedRoundRobin<rr::ListStorage> rr;
+    rr::Handle first = rr.add(0);
+    for (int i = 1; i < 3000; ++i) {
+        rr.add(i);
+    }
+
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        uint64_t last = 0;
+        while (!done.load()) {
+            auto stats = rr.stats();
+            EXPECT_GE(stats.total_selections, last);
+            last = stats.total_selections;
+        }
+    });
+    for (int i = 0; i < 300000; ++i) {
+        rr.next();
+    }
+    done.store(true);
+    reader.join();
+
+    auto stats = rr.stats();
+    EXPECT_EQ(stats.total_selections, 300000u);
+    EXPECT_EQ(stats.selections_of(first), 100u);
+}
+
+TEST(TraceTest, RecordsAddsSelectionsAndRemovals) {
+    rr::RoundRobin<int, rr::WeightedStorage, std::allocator<int>, rr::TraceRecorder<>> rr;
+    EXPECT_EQ(rr.stats().size(), 0u);
+    rr::Handle a = rr.add(1, 3);
+    rr::Handle b = rr.add(2);
+    rr.next();
+    rr.remove(a);
+    rr.next();
+    rr.remove_current();
+
+    rr::Trace trace = rr.stats();
+    ASSERT_EQ(trace.size(), 6u);
+    EXPECT_EQ(trace.dropped, 0u);
+    EXPECT_EQ(trace[0].op, rr::TraceOp::add);
+    EXPECT_EQ(trace[0].slot, a.index);
+    EXPECT_EQ(trace[0].arg, 3u);
+    EXPECT_EQ(trace[1].op, rr::TraceOp::add);
+    EXPECT_EQ(trace[1].slot, b.index);
+    EXPECT_EQ(trace[1].arg, 1u);
+    EXPECT_EQ(trace[2].op, rr::TraceOp::select);
+    EXPECT_EQ(trace[3].op, rr::TraceOp::remove);
+    EXPECT_EQ(trace[3].slot, a.index);
+    EXPECT_EQ(trace[4].op, rr::TraceOp::select);
+    EXPECT_EQ(trace[4].slot, b.index);
+    EXPECT_EQ(trace[5].op, rr::TraceOp::remove);
+    EXPECT_EQ(trace[5].slot, b.index);
+}
+
+TEST(TraceTest, RangesAndEmplaceAreRecorded) {
+    rr::RoundRobin<int, rr::ListStorage, std::allocator<int>, rr::TraceRecorder<>> rr;
+    std::vector<int> items{1, 2, 3};
+    rr.add_range(items.begin(), items.end());
+    // add_range still keeps the order of the range
+    EXPECT_EQ(rr.next(), 1);
+    rr.emplace(4);
+
+    rr::Trace trace = rr.stats();
+    ASSERT_EQ(trace.size(), 5u);
+    EXPECT_EQ(trace[3].op, rr::TraceOp::select);
+    for (size_t i : {0, 1, 2, 4}) {
+        EXPECT_EQ(trace[i].op, rr::TraceOp::add);
+    }
+}
+
+TEST(TraceTest, RingKeepsNewestEvents) {
+    rr::RoundRobin<int, rr::VectorStorage, std::allocator<int>, rr::TraceRecorder<64>> rr;
+    rr.add(0);
+    for (int i = 0; i < 100; ++i) {
+        rr.next();
+    }
+    rr::Trace trace = rr.stats();
+    EXPECT_EQ(trace.size() + trace.dropped, 101u);
+    EXPECT_LE(trace.size(), 64u);
+    EXPECT_GE(trace.size(), 63u);
+    EXPECT_EQ(trace[trace.size() - 1].op, rr::TraceOp::select);
+}
+
+TEST(TraceTest, WriteReadRoundTrip) {
+    rr::RoundRobin<int, rr::VectorStorage, std::allocator<int>, rr::TraceRecorder<>> rr;
+    for (int i = 0; i < 10; ++i) {
+        rr.add(i);
+    }
+    for (int i = 0; i < 25; ++i) {
+        rr.next();
+    }
+    rr::Trace trace = rr.stats();
+
+    std::stringstream buffer;
+    trace.write(buffer);
+    rr::Trace copy = rr::Trace::read(buffer);
+    EXPECT_EQ(copy.events, trace.events);
+    EXPECT_EQ(copy.dropped, trace.dropped);
+
+    std::stringstream truncated(buffer.str().substr(0, buffer.str().size() - 3));
+    EXPECT_THROW(rr::Trace::read(truncated), std::runtime_error);
+    std::stringstream garbage("not a trace at all");
+    EXPECT_THROW(rr::Trace::read(garbage), std::runtime_error);
+}
+
+TEST(TraceTest, MovedFromContainerRecordsAgain) {
+    rr::RoundRobin<int, rr::VectorStorage, std::allocator<int>, rr::TraceRecorder<>> rr;
+    rr.add(1);
+    auto moved = std::move(rr);
+    EXPECT_EQ(moved.stats().size(), 1u);
+    EXPECT_EQ(rr.stats().size(), 0u);
+    rr.add(2);
+    EXPECT_EQ(rr.stats().size(), 1u);
+}
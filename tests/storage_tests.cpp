@@ -0,0 +1,921 @@
+#include <gtest/gtest.h>
+#include "round_robin/round_robin.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+template<typename RR>
+class StorageTest : public ::testing::Test {
+protected:
+    RR rr;
+};
+
+using StorageTypes = ::testing::Types<
+    rr::RoundRobin<int, rr::ListStorage>,
+    rr::RoundRobin<int, rr::VectorStorage>,
+    rr::RoundRobin<int, rr::WeightedStorage>,
+    rr::PooledRoundRobin<int, rr::ListStorage>,
+    rr::PooledRoundRobin<int, rr::WeightedStorage>>;
+TYPED_TEST_SUITE(StorageTest, StorageTypes);
+
+TYPED_TEST(StorageTest, EveryItemOncePerCycle) {
+    const int n = 1000;
+    for (int i = 0; i < n; ++i) {
+        this->rr.add(i);
+    }
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        std::vector<int> seen(n, 0);
+        for (int i = 0; i < n; ++i) {
+            ++seen[this->rr.next()];
+        }
+        EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), n);
+    }
+}
+
+TYPED_TEST(StorageTest, RemovalKeepsCycleComplete) {
+    const int n = 10;
+    for (int i = 0; i < n; ++i) {
+        this->rr.add(i);
+    }
+    // Remove every other item during the first cycle; the rest of the
+    // cycle must still visit each survivor exactly once.
+    std::vector<int> seen(n, 0);
+    for (int i = 0; i < n; ++i) {
+        int value = this->rr.next();
+        ++seen[value];
+        if (value % 2 == 0) {
+            this->rr.remove_current();
+        }
+    }
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), n);
+    EXPECT_EQ(this->rr.size(), n / 2);
+
+    std::vector<int> next_cycle;
+    for (int i = 0; i < n / 2; ++i) {
+        next_cycle.push_back(this->rr.next());
+    }
+    std::sort(next_cycle.begin(), next_cycle.end());
+    EXPECT_EQ(next_cycle, (std::vector<int>{1, 3, 5, 7, 9}));
+}
+
+TYPED_TEST(StorageTest, AddMidCycleIsVisitedInSameCycle) {
+    this->rr.add(1);
+    this->rr.add(2);
+    this->rr.add(3);
+    std::vector<int> cycle{this->rr.next()};
+    this->rr.add(4);
+    for (int i = 0; i < 3; ++i) {
+        cycle.push_back(this->rr.next());
+    }
+    std::sort(cycle.begin(), cycle.end());
+    EXPECT_EQ(cycle, (std::vector<int>{1, 2, 3, 4}));
+}
+
+TYPED_TEST(StorageTest, DrainToEmpty) {
+    for (int i = 0; i < 5; ++i) {
+        this->rr.add(i);
+    }
+    while (!this->rr.empty()) {
+        this->rr.next();
+        this->rr.remove_current();
+    }
+    EXPECT_EQ(this->rr.try_next(), nullptr);
+    EXPECT_THROW(this->rr.remove_current(), std::runtime_error);
+}
+
+TYPED_TEST(StorageTest, BatchMatchesSequentialSelection) {
+    TypeParam sequential;
+    for (int i = 0; i < 7; ++i) {
+        this->rr.add(i);
+        sequential.add(i);
+    }
+    this->rr.next();
+    sequential.next();
+
+    std::vector<int*> batch(20);
+    EXPECT_EQ(this->rr.next_n(batch.data(), batch.size()), batch.size());
+    for (int* item : batch) {
+        EXPECT_EQ(*item, sequential.next());
+    }
+
+    // The last item of the batch is the current item
+    this->rr.remove_current();
+    sequential.remove_current();
+    int visited = 0;
+    EXPECT_EQ(this->rr.for_each_next(10, [&](int& item) {
+        EXPECT_EQ(item, sequential.next());
+        ++visited;
+    }), 10u);
+    EXPECT_EQ(visited, 10);
+}
+
+TYPED_TEST(StorageTest, BatchOnEmpty) {
+    int* out = nullptr;
+    EXPECT_EQ(this->rr.next_n(&out, 1), 0u);
+    EXPECT_EQ(out, nullptr);
+}
+
+TYPED_TEST(StorageTest, AddRangeAndEmplace) {
+    std::vector<int> values{5, 6, 7};
+    this->rr.reserve(4);
+    this->rr.add_range(values.begin(), values.end());
+    EXPECT_EQ(this->rr.emplace(8), 8);
+    EXPECT_EQ(this->rr.size(), 4);
+
+    std::vector<int> cycle;
+    for (int i = 0; i < 4; ++i) {
+        cycle.push_back(this->rr.next());
+    }
+    std::sort(cycle.begin(), cycle.end());
+    EXPECT_EQ(cycle, (std::vector<int>{5, 6, 7, 8}));
+}
+
+TYPED_TEST(StorageTest, SuspendedItemIsSkipped) {
+    for (int i = 0; i < 6; ++i) {
+        this->rr.add(i);
+    }
+    std::vector<int> seen(6, 0);
+    for (int i = 0; i < 6; ++i) {
+        int value = this->rr.next();
+        ++seen[value];
+        if (value == 2 || value == 5) {
+            this->rr.suspend_current();
+            EXPECT_THROW(this->rr.suspend_current(), std::runtime_error);
+        }
+    }
+    // The cycle in which the items were suspended is still complete
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), 6);
+    EXPECT_EQ(this->rr.size(), 4);
+    EXPECT_EQ(this->rr.suspended_count(), 2);
+
+    for (int i = 0; i < 40; ++i) {
+        int value = this->rr.next();
+        EXPECT_NE(value, 2);
+        EXPECT_NE(value, 5);
+    }
+}
+
+TYPED_TEST(StorageTest, ResumedItemJoinsCurrentCycle) {
+    for (int i = 0; i < 4; ++i) {
+        this->rr.add(i);
+    }
+    while (this->rr.next() != 3) {
+    }
+    this->rr.suspend_current();
+    EXPECT_EQ(this->rr.resume_if([](const int& v) { return v == 0; }), 0u);
+
+    std::vector<int> cycle{this->rr.next()};
+    EXPECT_EQ(this->rr.resume_if([](const int& v) { return v == 3; }), 1u);
+    EXPECT_EQ(this->rr.size(), 4);
+    EXPECT_EQ(this->rr.suspended_count(), 0);
+    for (int i = 0; i < 3; ++i) {
+        cycle.push_back(this->rr.next());
+    }
+    std::sort(cycle.begin(), cycle.end());
+    EXPECT_EQ(cycle, (std::vector<int>{0, 1, 2, 3}));
+}
+
+TYPED_TEST(StorageTest, SuspendEverything) {
+    for (int i = 0; i < 3; ++i) {
+        this->rr.add(i);
+    }
+    while (!this->rr.empty()) {
+        this->rr.next();
+        this->rr.suspend_current();
+    }
+    EXPECT_EQ(this->rr.try_next(), nullptr);
+    EXPECT_EQ(this->rr.suspended_count(), 3);
+
+    EXPECT_EQ(this->rr.resume_all(), 3u);
+    std::vector<int> cycle;
+    for (int i = 0; i < 3; ++i) {
+        cycle.push_back(this->rr.next());
+    }
+    std::sort(cycle.begin(), cycle.end());
+    EXPECT_EQ(cycle, (std::vector<int>{0, 1, 2}));
+}
+
+TYPED_TEST(StorageTest, RemoveWithSuspendedItems) {
+    for (int i = 0; i < 8; ++i) {
+        this->rr.add(i);
+    }
+    // Interleave suspensions and removals so erasing moves suspended items around
+    for (int i = 0; i < 8; ++i) {
+        int value = this->rr.next();
+        if (value % 2 == 0) {
+            this->rr.suspend_current();
+        } else if (value % 3 == 0) {
+            this->rr.remove_current();
+        }
+    }
+    EXPECT_EQ(this->rr.size(), 3);
+    EXPECT_EQ(this->rr.suspended_count(), 4);
+
+    EXPECT_EQ(this->rr.resume_if([](const int& v) { return v >= 4; }), 2u);
+    std::vector<int> cycle;
+    for (int i = 0; i < 5; ++i) {
+        cycle.push_back(this->rr.next());
+    }
+    std::sort(cycle.begin(), cycle.end());
+    EXPECT_EQ(cycle, (std::vector<int>{1, 4, 5, 6, 7}));
+}
+
+TYPED_TEST(StorageTest, HandleGetAndRemove) {
+    std::vector<rr::Handle> handles;
+    for (int i = 0; i < 5; ++i) {
+        handles.push_back(this->rr.add(i));
+    }
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_NE(this->rr.get(handles[i]), nullptr);
+        EXPECT_EQ(*this->rr.get(handles[i]), i);
+    }
+
+    EXPECT_TRUE(this->rr.remove(handles[3]));
+    EXPECT_FALSE(this->rr.remove(handles[3]));
+    EXPECT_FALSE(this->rr.contains(handles[3]));
+    EXPECT_EQ(this->rr.get(handles[3]), nullptr);
+    EXPECT_EQ(this->rr.size(), 4);
+
+    // The freed slot is reused, but the old handle stays stale
+    rr::Handle reused = this->rr.add(7);
+    EXPECT_EQ(reused.index, handles[3].index);
+    EXPECT_EQ(this->rr.get(handles[3]), nullptr);
+    EXPECT_EQ(*this->rr.get(reused), 7);
+    EXPECT_EQ(this->rr.get(rr::Handle{}), nullptr);
+
+    // Lookups work through a const reference too
+    const auto& view = this->rr;
+    EXPECT_TRUE(view.contains(reused));
+    EXPECT_FALSE(view.contains(handles[3]));
+    EXPECT_EQ(*view.get(reused), 7);
+    EXPECT_EQ(view.get(handles[3]), nullptr);
+}
+
+TYPED_TEST(StorageTest, RemoveByHandleKeepsCycleComplete) {
+    const int n = 64;
+    std::vector<rr::Handle> handles;
+    for (int i = 0; i < n; ++i) {
+        handles.push_back(this->rr.add(i));
+    }
+    std::vector<bool> removed(n, false);
+    for (int cycle = 0; cycle < 4; ++cycle) {
+        // Remove arbitrary items, visited and unvisited, while the cycle runs;
+        // every surviving item must still come up exactly once.
+        const int remaining = static_cast<int>(this->rr.size());
+        std::vector<int> seen(n, 0);
+        int visited = 0;
+        for (int step = 0; visited < remaining; ++step) {
+            int value = this->rr.next();
+            ++seen[value];
+            ++visited;
+            int victim = (value * 7 + step * 13 + cycle) % n;
+            if (step % 3 == 0 && !removed[victim] && victim != value) {
+                EXPECT_TRUE(this->rr.remove(handles[victim]));
+                removed[victim] = true;
+                visited += seen[victim] == 0 ? 1 : 0; // An unvisited victim shortens the cycle
+            }
+        }
+        for (int i = 0; i < n; ++i) {
+            EXPECT_LE(seen[i], 1) << "item " << i << " in cycle " << cycle;
+            if (!removed[i]) {
+                EXPECT_EQ(seen[i], 1) << "item " << i << " in cycle " << cycle;
+            }
+        }
+    }
+}
+
+TYPED_TEST(StorageTest, RemoveCurrentByHandle) {
+    rr::Handle a = this->rr.add(1);
+    this->rr.add(2);
+    while (this->rr.next() != 1) {
+    }
+    EXPECT_TRUE(this->rr.remove(a));
+    EXPECT_THROW(this->rr.remove_current(), std::runtime_error);
+    EXPECT_EQ(this->rr.next(), 2);
+    EXPECT_EQ(this->rr.next(), 2);
+}
+
+TYPED_TEST(StorageTest, SuspendAndResumeByHandle) {
+    std::vector<rr::Handle> handles;
+    for (int i = 0; i < 4; ++i) {
+        handles.push_back(this->rr.add(i));
+    }
+    EXPECT_TRUE(this->rr.suspend(handles[1]));
+    EXPECT_FALSE(this->rr.suspend(handles[1]));
+    EXPECT_EQ(*this->rr.get(handles[1]), 1);
+    for (int i = 0; i < 12; ++i) {
+        EXPECT_NE(this->rr.next(), 1);
+    }
+
+    // Suspended items can be removed directly
+    EXPECT_TRUE(this->rr.suspend(handles[2]));
+    EXPECT_TRUE(this->rr.remove(handles[2]));
+    EXPECT_FALSE(this->rr.resume(handles[2]));
+    EXPECT_EQ(this->rr.suspended_count(), 1);
+
+    EXPECT_TRUE(this->rr.resume(handles[1]));
+    EXPECT_FALSE(this->rr.resume(handles[1]));
+    std::vector<int> cycle;
+    for (int i = 0; i < 3; ++i) {
+        cycle.push_back(this->rr.next());
+    }
+    std::sort(cycle.begin(), cycle.end());
+    EXPECT_EQ(cycle, (std::vector<int>{0, 1, 3}));
+}
+
+TYPED_TEST(StorageTest, LeasedItemIsSkipped) {
+    for (int i = 0; i < 4; ++i) {
+        this->rr.add(i);
+    }
+    {
+        auto lease = this->rr.lease();
+        int leased = *lease;
+        EXPECT_EQ(this->rr.size(), 3);
+        EXPECT_EQ(this->rr.leased_count(), 1);
+        for (int i = 0; i < 30; ++i) {
+            EXPECT_NE(this->rr.next(), leased);
+        }
+        // Lookup through the handle stays valid as the rotation goes on
+        EXPECT_EQ(*lease, leased);
+        EXPECT_EQ(*this->rr.get(lease.handle()), leased);
+    }
+    EXPECT_EQ(this->rr.size(), 4);
+    EXPECT_EQ(this->rr.leased_count(), 0);
+
+    std::vector<int> seen(4, 0);
+    for (int i = 0; i < 8; ++i) {
+        ++seen[this->rr.next()];
+    }
+    EXPECT_EQ(seen, (std::vector<int>{2, 2, 2, 2}));
+}
+
+TYPED_TEST(StorageTest, LeaseEverything) {
+    this->rr.add(1);
+    this->rr.add(2);
+    auto a = this->rr.lease();
+    auto b = this->rr.lease();
+    EXPECT_NE(*a, *b);
+    EXPECT_TRUE(this->rr.empty());
+    EXPECT_FALSE(this->rr.try_lease());
+    EXPECT_THROW(this->rr.lease(), std::runtime_error);
+    EXPECT_EQ(this->rr.try_next(), nullptr);
+
+    b.reset();
+    EXPECT_FALSE(b);
+    EXPECT_EQ(this->rr.size(), 1);
+    auto c = std::move(a);
+    EXPECT_FALSE(a);
+    c = this->rr.lease();
+    EXPECT_EQ(this->rr.leased_count(), 1);
+    EXPECT_EQ(this->rr.size(), 1);
+}
+
+TYPED_TEST(StorageTest, ResumeLeavesLeasedItemsOut) {
+    this->rr.add(1);
+    this->rr.add(2);
+    this->rr.add(3);
+    while (this->rr.next() != 3) {
+    }
+    this->rr.suspend_current();
+    auto lease = this->rr.try_lease();
+    ASSERT_TRUE(lease);
+    rr::Handle leased = lease.handle();
+
+    EXPECT_FALSE(this->rr.resume(leased));
+    EXPECT_FALSE(this->rr.suspend(leased));
+    EXPECT_EQ(this->rr.resume_all(), 1u);
+    EXPECT_EQ(this->rr.leased_count(), 1);
+    EXPECT_EQ(this->rr.size(), 2);
+    EXPECT_EQ(this->rr.suspended_count(), 0);
+
+    // Other items can be suspended and removed around a live lease
+    rr::Handle d = this->rr.add(4);
+    EXPECT_TRUE(this->rr.suspend(d));
+    EXPECT_TRUE(this->rr.remove(d));
+    EXPECT_EQ(this->rr.leased_count(), 1);
+    EXPECT_NE(lease.get(), nullptr);
+}
+
+TYPED_TEST(StorageTest, RemoveLeasedItem) {
+    this->rr.add(1);
+    this->rr.add(2);
+    auto lease = this->rr.lease();
+    EXPECT_TRUE(this->rr.remove(lease.handle()));
+    EXPECT_EQ(this->rr.leased_count(), 0);
+    EXPECT_EQ(lease.get(), nullptr);
+    lease.reset();
+    EXPECT_EQ(this->rr.size(), 1);
+
+    // The buffer-based storages move leased items around on removal
+    auto first = this->rr.lease();
+    int value = *first;
+    this->rr.add(5);
+    this->rr.add(6);
+    auto second = this->rr.lease();
+    EXPECT_TRUE(this->rr.remove(this->rr.add(7)));
+    EXPECT_EQ(*first, value);
+    EXPECT_NE(*second, value);
+    EXPECT_EQ(this->rr.leased_count(), 2);
+    EXPECT_EQ(this->rr.size(), 1);
+}
+
+TYPED_TEST(StorageTest, MoveMidCycleContinuesRotation) {
+    for (int i = 0; i < 5; ++i) {
+        this->rr.add(i);
+    }
+    // Reference sequence from an identical container that is not moved
+    TypeParam reference;
+    for (int i = 0; i < 5; ++i) {
+        reference.add(i);
+    }
+    for (int i = 0; i < 7; ++i) {
+        EXPECT_EQ(this->rr.next(), reference.next());
+    }
+
+    TypeParam moved(std::move(this->rr));
+    EXPECT_TRUE(this->rr.empty());
+    moved.remove_current();
+    reference.remove_current();
+    for (int i = 0; i < 9; ++i) {
+        EXPECT_EQ(moved.next(), reference.next());
+    }
+
+    this->rr = std::move(moved);
+    EXPECT_TRUE(moved.empty());
+    for (int i = 0; i < 9; ++i) {
+        EXPECT_EQ(this->rr.next(), reference.next());
+    }
+
+    // The moved-from container is empty but usable
+    moved.add(42);
+    EXPECT_EQ(moved.next(), 42);
+}
+
+TYPED_TEST(StorageTest, MoveAtEndOfCycle) {
+    for (int i = 0; i < 3; ++i) {
+        this->rr.add(i);
+    }
+    std::vector<int> cycle;
+    for (int i = 0; i < 3; ++i) {
+        cycle.push_back(this->rr.next());
+    }
+
+    TypeParam moved(std::move(this->rr));
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(moved.next(), cycle[i % 3]);
+    }
+}
+
+TYPED_TEST(StorageTest, MoveKeepsHandles) {
+    rr::Handle a = this->rr.add(1);
+    rr::Handle b = this->rr.add(2);
+    this->rr.suspend(b);
+
+    TypeParam moved(std::move(this->rr));
+    EXPECT_FALSE(this->rr.contains(a));
+    ASSERT_NE(moved.get(a), nullptr);
+    EXPECT_EQ(*moved.get(a), 1);
+    EXPECT_EQ(moved.suspended_count(), 1);
+    EXPECT_TRUE(moved.resume(b));
+    EXPECT_TRUE(moved.remove(a));
+    EXPECT_EQ(moved.next(), 2);
+}
+
+TYPED_TEST(StorageTest, SwapExchangesRotationState) {
+    TypeParam other;
+    for (int i = 0; i < 4; ++i) {
+        this->rr.add(i);
+        other.add(10 + i);
+    }
+    this->rr.next();
+    std::vector<int> expected_this;
+    std::vector<int> expected_other;
+    {
+        TypeParam a;
+        TypeParam b;
+        for (int i = 0; i < 4; ++i) {
+            a.add(i);
+            b.add(10 + i);
+        }
+        a.next();
+        for (int i = 0; i < 6; ++i) {
+            expected_this.push_back(a.next());
+            expected_other.push_back(b.next());
+        }
+    }
+
+    swap(this->rr, other);
+    EXPECT_EQ(other.size(), 4);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(other.next(), expected_this[i]);
+        EXPECT_EQ(this->rr.next(), expected_other[i]);
+    }
+}
+
+TEST(VectorStorageTest, AddRangeKeepsOrder) {
+    rr::RoundRobin<int, rr::VectorStorage> rr;
+    std::vector<int> values{3, 1, 2};
+    rr.add_range(values.begin(), values.end());
+    EXPECT_EQ(rr.next(), 3);
+    EXPECT_EQ(rr.next(), 1);
+    EXPECT_EQ(rr.next(), 2);
+}
+
+TEST(VectorStorageTest, InsertionOrder) {
+    rr::RoundRobin<std::string, rr::VectorStorage> rr;
+    rr.add("first");
+    rr.add("second");
+    rr.add("third");
+    EXPECT_EQ(rr.next(), "first");
+    EXPECT_EQ(rr.next(), "second");
+    EXPECT_EQ(rr.next(), "third");
+    EXPECT_EQ(rr.next(), "first");
+}
+
+TEST(VectorStorageTest, SwapAndPopRemoval) {
+    rr::RoundRobin<int, rr::VectorStorage> rr;
+    for (int i = 0; i < 4; ++i) {
+        rr.add(i);
+    }
+    EXPECT_EQ(rr.next(), 0);
+    EXPECT_EQ(rr.next(), 1);
+    rr.remove_current();          // last item takes the freed slot
+    EXPECT_EQ(rr.next(), 3);
+    EXPECT_EQ(rr.next(), 2);
+    EXPECT_EQ(rr.next(), 0);      // new cycle
+}
+
+TEST(VectorStorageTest, MoveOnlyItems) {
+    rr::RoundRobin<std::unique_ptr<int>, rr::VectorStorage> rr;
+    rr.add(std::make_unique<int>(1));
+    rr.add(std::make_unique<int>(2));
+    EXPECT_EQ(*rr.next(), 1);
+    rr.remove_current();
+    EXPECT_EQ(*rr.next(), 2);
+
+    rr::RoundRobin<std::unique_ptr<int>, rr::VectorStorage> moved(std::move(rr));
+    EXPECT_EQ(moved.size(), 1);
+    EXPECT_TRUE(rr.empty());
+}
+
+TEST(ListStorageTest, StableAddresses) {
+    rr::RoundRobin<int, rr::ListStorage> rr;
+    rr.add(1);
+    int* first = rr.try_next();
+    for (int i = 0; i < 1000; ++i) {
+        rr.add(i);
+    }
+    EXPECT_EQ(*first, 1);
+}
+
+TEST(ListStorageTest, SuspendKeepsAddress) {
+    rr::RoundRobin<int, rr::ListStorage> rr;
+    rr.add(1);
+    rr.add(2);
+    int* item = rr.try_next();
+    rr.suspend_current();
+    rr.resume_all();
+    while (rr.try_next() != item) {
+    }
+    EXPECT_EQ(*item, rr.next() == 1 ? 2 : 1);
+}
+
+TEST(WeightedStorageTest, SelectsInProportionToWeight) {
+    rr::RoundRobin<std::string, rr::WeightedStorage> rr;
+    rr.add("a", 5);
+    rr.add("b", 1);
+    rr.add("c", 1);
+
+    std::vector<std::string> sequence;
+    for (int i = 0; i < 700; ++i) {
+        sequence.push_back(rr.next());
+    }
+    EXPECT_EQ(std::count(sequence.begin(), sequence.end(), "a"), 500);
+    EXPECT_EQ(std::count(sequence.begin(), sequence.end(), "b"), 100);
+    EXPECT_EQ(std::count(sequence.begin(), sequence.end(), "c"), 100);
+
+    // Smooth: the light items are interleaved, not sent after a burst of "a"
+    size_t longest_run = 0;
+    size_t run = 0;
+    for (const auto& s : sequence) {
+        run = (s == "a") ? run + 1 : 0;
+        longest_run = std::max(longest_run, run);
+    }
+    EXPECT_LE(longest_run, 3u);  // Duplicating "a" five times would give runs of 5
+}
+
+TEST(WeightedStorageTest, EqualWeightsRotateInFixedOrder) {
+    rr::RoundRobin<int, rr::WeightedStorage> rr;
+    for (int i = 0; i < 5; ++i) {
+        rr.add(i, 3);
+    }
+    std::vector<int> first_cycle;
+    for (int i = 0; i < 5; ++i) {
+        first_cycle.push_back(rr.next());
+    }
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        for (int i = 0; i < 5; ++i) {
+            EXPECT_EQ(rr.next(), first_cycle[i]);
+        }
+    }
+}
+
+TEST(WeightedStorageTest, SetCurrentWeight) {
+    rr::RoundRobin<std::string, rr::WeightedStorage> rr;
+    rr.add("a");
+    rr.add("b");
+    EXPECT_THROW(rr.set_current_weight(2), std::runtime_error);
+
+    std::string heavy = rr.next();
+    rr.set_current_weight(3);
+    EXPECT_THROW(rr.set_current_weight(0), std::invalid_argument);
+
+    int count = 0;
+    for (int i = 0; i < 400; ++i) {
+        count += rr.next() == heavy;
+    }
+    EXPECT_NEAR(count, 300, 2);
+}
+
+TEST(WeightedStorageTest, SetWeightByHandle) {
+    rr::RoundRobin<std::string, rr::WeightedStorage> rr;
+    rr.add("a");
+    rr.add("b");
+    rr::Handle c = rr.add("c");
+    while (rr.next() != "a") {
+    }
+
+    // Reweight an item that is not current, without waiting for its turn
+    EXPECT_TRUE(rr.set_weight(c, 4));
+    EXPECT_THROW(rr.set_weight(c, 0), std::invalid_argument);
+    std::map<std::string, int> counts;
+    for (int i = 0; i < 600; ++i) {
+        ++counts[rr.next()];
+    }
+    EXPECT_NEAR(counts["c"], 400, 2);
+    EXPECT_NEAR(counts["a"], 100, 2);
+    EXPECT_NEAR(counts["b"], 100, 2);
+
+    // A suspended item takes its new weight back into the rotation
+    rr.suspend(c);
+    EXPECT_TRUE(rr.set_weight(c, 1));
+    rr.resume(c);
+    counts.clear();
+    for (int i = 0; i < 300; ++i) {
+        ++counts[rr.next()];
+    }
+    EXPECT_NEAR(counts["c"], 100, 2);
+
+    // So does a leased one once it is returned
+    {
+        auto lease = rr.lease();
+        EXPECT_TRUE(rr.set_weight(lease.handle(), 2));
+    }
+    counts.clear();
+    for (int i = 0; i < 400; ++i) {
+        ++counts[rr.next()];
+    }
+    EXPECT_EQ(counts.size(), 3u);
+    auto doubled = std::count_if(counts.begin(), counts.end(),
+                                 [](const auto& entry) { return std::abs(entry.second - 200) <= 2; });
+    EXPECT_EQ(doubled, 1);
+
+    rr.remove(c);
+    EXPECT_FALSE(rr.set_weight(c, 2));
+}
+
+TEST(WeightedStorageTest, RemoveKeepsProportions) {
+    rr::RoundRobin<int, rr::WeightedStorage> rr;
+    rr.add(0, 1);
+    rr.add(1, 2);
+    rr.add(2, 4);
+    EXPECT_THROW(rr.add(3, 0), std::invalid_argument);
+
+    while (rr.next() != 1) {
+    }
+    rr.remove_current();
+    EXPECT_EQ(rr.size(), 2);
+
+    std::vector<int> counts(3, 0);
+    for (int i = 0; i < 500; ++i) {
+        ++counts[rr.next()];
+    }
+    EXPECT_EQ(counts[1], 0);
+    EXPECT_NEAR(counts[2], 4 * counts[0], 4);
+}
+
+TEST(WeightedStorageTest, MoveKeepsWeights) {
+    rr::RoundRobin<int, rr::WeightedStorage> rr;
+    rr.add(0, 1);
+    rr.add(1, 3);
+    for (int i = 0; i < 5; ++i) {
+        rr.next();
+    }
+
+    rr::RoundRobin<int, rr::WeightedStorage> moved;
+    moved = std::move(rr);
+    std::vector<int> counts(2, 0);
+    for (int i = 0; i < 400; ++i) {
+        ++counts[moved.next()];
+    }
+    EXPECT_NEAR(counts[1], 300, 2);
+}
+
+TEST(WeightedStorageTest, ResumedItemKeepsWeight) {
+    rr::RoundRobin<int, rr::WeightedStorage> rr;
+    rr.add(0, 1);
+    rr.add(1, 3);
+    while (rr.next() != 1) {
+    }
+    rr.suspend_current();
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(rr.next(), 0);
+    }
+    rr.resume_all();
+
+    // No burst of catch-up selections after a long suspension
+    std::vector<int> counts(2, 0);
+    for (int i = 0; i < 400; ++i) {
+        ++counts[rr.next()];
+    }
+    EXPECT_NEAR(counts[1], 300, 3);
+}
+
+TEST(DeficitStorageTest, FairByCostNotBySelection) {
+    rr::RoundRobin<char, rr::DeficitStorage> rr;
+    rr.add('L', 1500); // Large requests
+    rr.add('S', 1500); // Small requests
+    uint64_t large = 0;
+    uint64_t small = 0;
+    for (int i = 0; i < 10000; ++i) {
+        if (rr.next() == 'L') {
+            rr.charge_current(1500);
+            large += 1500;
+        } else {
+            rr.charge_current(100);
+            small += 100;
+        }
+    }
+    EXPECT_NEAR(static_cast<double>(large) / small, 1.0, 0.01);
+}
+
+TEST(DeficitStorageTest, ServesInProportionToQuantum) {
+    rr::RoundRobin<int, rr::DeficitStorage> rr;
+    rr.add(0, 1000);
+    rr.add(1, 3000);
+    std::vector<uint64_t> served(2, 0);
+    for (int i = 0; i < 4000; ++i) {
+        int item = rr.next();
+        uint64_t cost = item == 0 ? 300 : 700; // Costs need not divide the quantum
+        rr.charge_current(cost);
+        served[item] += cost;
+    }
+    EXPECT_NEAR(static_cast<double>(served[1]) / served[0], 3.0, 0.05);
+}
+
+TEST(DeficitStorageTest, UnitCostIsPlainRotation) {
+    rr::RoundRobin<int, rr::DeficitStorage> rr;
+    for (int i = 0; i < 5; ++i) {
+        rr.add(i);
+    }
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        for (int i = 0; i < 5; ++i) {
+            EXPECT_EQ(rr.next(), i);
+            rr.charge_current(1);
+        }
+    }
+    // Uncharged selections stay with the current item
+    EXPECT_EQ(rr.next(), 0);
+    EXPECT_EQ(rr.next(), 0);
+}
+
+TEST(DeficitStorageTest, LargeChargeIsPaidOffWithoutSpinning) {
+    rr::RoundRobin<int, rr::DeficitStorage> rr;
+    rr::Handle debtor = rr.add(0);
+    rr::Handle other = rr.add(1, 3);
+    ASSERT_TRUE(rr.charge(debtor, uint64_t{1} << 32));
+
+    // Repaying the debt one quantum per pass would take 2^32 passes
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(rr.next(), 1);
+    rr.charge_current(3);
+    EXPECT_EQ(rr.next(), 1);
+    rr.charge_current(uint64_t{1} << 40);
+    EXPECT_EQ(rr.next(), 0); // Back in credit before item 1, which owes more
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    // Both as deep in debt as it goes: still one step, and the larger quantum recovers first
+    ASSERT_TRUE(rr.charge(debtor, UINT64_MAX));
+    ASSERT_TRUE(rr.charge(other, UINT64_MAX));
+    start = std::chrono::steady_clock::now();
+    EXPECT_EQ(rr.next(), 1);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(DeficitStorageTest, HugeCostSaturates) {
+    rr::RoundRobin<int, rr::DeficitStorage> rr;
+    rr::Handle debtor = rr.add(0);
+    rr.add(1);
+    // A cost above INT64_MAX must be a debt, not wrap around into credit
+    ASSERT_TRUE(rr.charge(debtor, (uint64_t{1} << 63) | 5));
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(rr.next(), 1);
+        rr.charge_current(1);
+    }
+    // Driven as deep into debt, item 1 now owes more than the first debtor
+    rr.charge_current(UINT64_MAX);
+    EXPECT_EQ(rr.next(), 0);
+}
+
+TEST(DeficitStorageTest, IdleFlowsDropOut) {
+    const int flows = 100000;
+    rr::RoundRobin<int, rr::DeficitStorage> rr;
+    rr.reserve(flows);
+    std::vector<rr::Handle> handles;
+    for (int i = 0; i < flows; ++i) {
+        handles.push_back(rr.add(i, 1500));
+    }
+    // Every flow drains its backlog once and goes idle, except two
+    for (int i = 0; i < flows; ++i) {
+        int flow = rr.next();
+        rr.charge_current(1500);
+        if (flow != 7 && flow != 42) {
+            rr.suspend_current();
+        }
+    }
+    EXPECT_EQ(rr.size(), 2);
+    EXPECT_EQ(rr.suspended_count(), flows - 2);
+    for (int i = 0; i < 100; ++i) {
+        int flow = rr.next();
+        EXPECT_TRUE(flow == 7 || flow == 42);
+        rr.charge_current(1500);
+    }
+
+    // New work for an idle flow puts it back in the rotation
+    EXPECT_TRUE(rr.resume(handles[99999]));
+    bool served = false;
+    for (int i = 0; i < 3 && !served; ++i) {
+        served = rr.next() == 99999;
+        rr.charge_current(1500);
+    }
+    EXPECT_TRUE(served);
+}
+
+TEST(DeficitStorageTest, DebtSurvivesSuspension) {
+    rr::RoundRobin<int, rr::DeficitStorage> rr;
+    rr::Handle big = rr.add(0, 100);
+    rr.add(1, 100);
+    EXPECT_EQ(rr.next(), 0);
+    rr.charge_current(1000); // 900 in debt: back in credit on the tenth pass
+    rr.suspend_current();
+    EXPECT_TRUE(rr.resume(big));
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(rr.next(), 1);
+        rr.charge_current(100);
+    }
+    EXPECT_EQ(rr.next(), 0);
+}
+
+TEST(DeficitStorageTest, SetWeightByHandle) {
+    rr::RoundRobin<char, rr::DeficitStorage> rr;
+    rr.add('A', 10);
+    rr::Handle b = rr.add('B', 10);
+    EXPECT_EQ(rr.next(), 'A');
+    EXPECT_TRUE(rr.set_weight(b, 30));
+
+    std::map<char, uint64_t> served;
+    for (int i = 0; i < 4000; ++i) {
+        char item = rr.next();
+        rr.charge_current(1);
+        ++served[item];
+    }
+    EXPECT_NEAR(served['B'], 3 * served['A'], 30);
+
+    rr.remove(b);
+    EXPECT_FALSE(rr.set_weight(b, 10));
+}
+
+TEST(DeficitStorageTest, HandlesAndRemoval) {
+    rr::RoundRobin<int, rr::DeficitStorage> rr;
+    rr::Handle a = rr.add(1, 10);
+    rr::Handle b = rr.add(2, 10);
+    EXPECT_EQ(rr.next(), 1);
+    EXPECT_TRUE(rr.charge(a, 10));
+    EXPECT_EQ(rr.next(), 2);
+    rr.remove_current();
+    EXPECT_FALSE(rr.charge(b, 10));
+    const auto& view = rr;
+    EXPECT_FALSE(view.contains(b));
+    EXPECT_EQ(*view.get(a), 1);
+    EXPECT_EQ(rr.next(), 1);
+    rr.set_current_weight(20);
+    EXPECT_THROW(rr.set_current_weight(0), std::invalid_argument);
+    rr.remove_current();
+    EXPECT_TRUE(rr.empty());
+    EXPECT_THROW(rr.charge_current(1), std::runtime_error);
+}
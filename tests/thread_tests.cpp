@@ -62,53 +62,6 @@ TEST_F(AdvancedRoundRobinTest, MultiThreadedAccess) {
     }
 }
 
-// Test removal during multi-threaded access
-TEST_F(AdvancedRoundRobinTest, RemovalDuringMultiThreadedAccess) {
-    std::queue<std::string> removalQueue;
-    std::thread threads[2];
-
-    // Lambda function for the remover thread
-    auto remover = [&]() {
-        for (int i = 0; i < 5; ++i) { // Remove 5 times
-            std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Simulate delay
-            if (str_rr.empty()) {
-                break;
-            }
-            std::string item = str_rr.next();
-            {
-                std::lock_guard<std::mutex> lock(mtx);
-                removalQueue.push(item);
-            }
-            str_rr.remove_current();
-        }
-    };
-
-    // Lambda function for the accessor thread
-    auto accessor = [&]() {
-        for (int i = 0; i < 10; ++i) { // Run 10 iterations
-            std::string* item = str_rr.try_next();
-            if (!item) { // Check if try_next returned nullptr (empty container)
-                break; // Exit loop if empty
-            }
-            // Use *item to access the string
-        }
-    };
-
-    threads[0] = std::thread(remover);
-    threads[1] = std::thread(accessor);
-
-    // Wait for threads to finish
-    for (auto& thread : threads) {
-        thread.join();
-    }
-
-    // Verify removals
-    EXPECT_EQ(removalQueue.size(), 3);
-    for (int i = 0; i < 3; ++i) {
-        removalQueue.pop();
-    }
-}
-
 // Stress test with many threads and iterations
 TEST_F(AdvancedRoundRobinTest, StressTest) {
     const int numThreads = 10;
@@ -0,0 +1,312 @@
+// Replays a trace recorded with rr::TraceRecorder against several RoundRobin
+// storages and reports throughput, selection fairness and selection latency.
+//
+//   rr_replay [--storage NAME] [--repeat N] TRACE_FILE
+//   rr_replay [--storage NAME] [--repeat N] --synthetic EVENTS [--write TRACE_FILE]
+//
+// NAME is list, vector, weighted, pooled or all (the default). DeficitStorage
+// is left out because traces do not record charges.
+
+#include "round_robin/round_robin.hpp"
+#include "round_robin/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief A trace made self-contained: items seen before their add (because
+ *        the ring dropped it) are added up front with weight 1.
+ */
+struct Workload {
+    std::vector<rr::TraceEvent> initial; ///< Adds to run before the events.
+    std::vector<rr::TraceEvent> events; ///< The trace itself.
+    uint32_t slots = 0; ///< One past the largest slot used.
+    size_t selections = 0; ///< Number of select events.
+};
+
+Workload prepare(const rr::Trace& trace) {
+    Workload work;
+    std::vector<bool> seen;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        rr::TraceEvent event = trace[i];
+        if (event.slot >= seen.size()) {
+            seen.resize(event.slot + 1, false);
+        }
+        if (event.op == rr::TraceOp::add) {
+            seen[event.slot] = true;
+        } else if (!seen[event.slot]) {
+            seen[event.slot] = true;
+            work.initial.push_back(rr::TraceEvent{rr::TraceOp::add, event.slot, 1});
+        }
+        work.selections += event.op == rr::TraceOp::select;
+        work.events.push_back(event);
+    }
+    work.slots = static_cast<uint32_t>(seen.size());
+    return work;
+}
+
+/**
+ * @brief Records a synthetic trace: a weighted pool with steady churn.
+ */
+rr::Trace synthesize(size_t events) {
+    rr::RoundRobin<uint32_t, rr::WeightedStorage, std::allocator<uint32_t>, rr::TraceRecorder<(size_t{1} << 22)>> pool;
+    std::mt19937 random(42);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        pool.add(i, 1 + random() % 4);
+    }
+    uint32_t next_value = 1000;
+    for (size_t i = 1000; i < events; ++i) {
+        pool.next();
+        if (random() % 64 == 0) {
+            pool.remove_current();
+            pool.add(next_value++, 1 + random() % 4);
+            ++i;
+        }
+    }
+    return pool.stats();
+}
+
+struct Report {
+    double events_per_second = 0;
+    std::vector<uint64_t> latency_ns; ///< Per-selection times, sorted.
+    std::vector<double> ratios; ///< Selections received over selections due, per item.
+};
+
+/**
+ * @brief Replays the workload once.
+ * @tparam RR The RoundRobin variant; items are the recorded slots.
+ * @tparam Weighted Pass recorded weights to add().
+ * @tparam Timed Time every selection and measure fairness.
+ */
+template<typename RR, bool Weighted, bool Timed>
+void replay(const Workload& work, Report& report) {
+    RR pool;
+    std::vector<rr::Handle> handles(work.slots);
+    // Fairness bookkeeping: an item with weight w is due w / W of each selection,
+    // W being the total weight at that moment; integral sums 1 / W over selections
+    std::vector<uint64_t> selected(Timed ? work.slots : 0);
+    std::vector<double> joined(Timed ? work.slots : 0);
+    std::vector<unsigned> weight(Timed ? work.slots : 0);
+    double integral = 0;
+    uint64_t total_weight = 0;
+
+    auto settle = [&](uint32_t slot) {
+        double due = weight[slot] * (integral - joined[slot]);
+        if (due >= 10) { // Too few selections due to say anything about fairness
+            report.ratios.push_back(static_cast<double>(selected[slot]) / due);
+        }
+        total_weight -= weight[slot];
+    };
+    auto apply = [&](const rr::TraceEvent& event) {
+        switch (event.op) {
+            case rr::TraceOp::add: {
+                unsigned w = Weighted ? std::max(event.arg, 1u) : 1u;
+                if constexpr (Weighted) {
+                    handles[event.slot] = pool.add(event.slot, w);
+                } else {
+                    handles[event.slot] = pool.add(event.slot);
+                }
+                if constexpr (Timed) {
+                    selected[event.slot] = 0;
+                    joined[event.slot] = integral;
+                    weight[event.slot] = w;
+                    total_weight += w;
+                }
+                break;
+            }
+            case rr::TraceOp::select: {
+                if constexpr (Timed) {
+                    auto start = Clock::now();
+                    uint32_t* item = pool.try_next();
+                    auto elapsed = Clock::now() - start;
+                    report.latency_ns.push_back(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+                    if (item) {
+                        ++selected[*item];
+                        integral += 1.0 / static_cast<double>(total_weight);
+                    }
+                } else {
+                    pool.try_next();
+                }
+                break;
+            }
+            case rr::TraceOp::remove:
+                if (pool.remove(handles[event.slot])) {
+                    if constexpr (Timed) {
+                        settle(event.slot);
+                    }
+                }
+                break;
+        }
+    };
+
+    for (const rr::TraceEvent& event : work.initial) {
+        apply(event);
+    }
+    auto start = Clock::now();
+    for (const rr::TraceEvent& event : work.events) {
+        apply(event);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if constexpr (Timed) {
+        for (uint32_t slot = 0; slot < work.slots; ++slot) {
+            if (pool.contains(handles[slot])) {
+                settle(slot);
+            }
+        }
+        std::sort(report.latency_ns.begin(), report.latency_ns.end());
+    } else {
+        report.events_per_second = std::max(report.events_per_second, work.events.size() / seconds);
+    }
+}
+
+template<typename RR, bool Weighted>
+Report measure(const Workload& work, int repeat) {
+    Report report;
+    for (int i = 0; i < repeat; ++i) {
+        replay<RR, Weighted, false>(work, report);
+    }
+    report.latency_ns.reserve(work.selections);
+    replay<RR, Weighted, true>(work, report);
+    return report;
+}
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+}
+
+void print(const char* name, const Report& report) {
+    std::printf("%-9s %12.0f %6llu %6llu %6llu %7llu %8llu",
+                name,
+                report.events_per_second,
+                static_cast<unsigned long long>(percentile(report.latency_ns, 0.50)),
+                static_cast<unsigned long long>(percentile(report.latency_ns, 0.90)),
+                static_cast<unsigned long long>(percentile(report.latency_ns, 0.99)),
+                static_cast<unsigned long long>(percentile(report.latency_ns, 0.999)),
+                static_cast<unsigned long long>(report.latency_ns.empty() ? 0 : report.latency_ns.back()));
+
+    // Jain's index over the per-item ratios: 1 when every item got exactly its share
+    double sum = 0;
+    double squares = 0;
+    for (double ratio : report.ratios) {
+        sum += ratio;
+        squares += ratio * ratio;
+    }
+    double jain = squares > 0 ? sum * sum / (static_cast<double>(report.ratios.size()) * squares) : 1.0;
+    std::printf(" %8.5f %7zu\n", jain, report.ratios.size());
+
+    static const double edges[] = {0.5, 0.9, 0.99, 1.01, 1.1, 2.0};
+    size_t buckets[7] = {};
+    for (double ratio : report.ratios) {
+        size_t bucket = 0;
+        while (bucket < 6 && ratio >= edges[bucket]) {
+            ++bucket;
+        }
+        ++buckets[bucket];
+    }
+    std::printf("          share received / due:  <0.5 %zu | <0.9 %zu | <0.99 %zu | ~1 %zu | <1.1 %zu | <2 %zu | >=2 %zu\n",
+                buckets[0], buckets[1], buckets[2], buckets[3], buckets[4], buckets[5], buckets[6]);
+}
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: rr_replay [--storage list|vector|weighted|pooled|all] [--repeat N] TRACE_FILE\n"
+                 "       rr_replay [--storage ...] [--repeat N] --synthetic EVENTS [--write TRACE_FILE]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string storage = "all";
+    std::string input;
+    std::string output;
+    size_t synthetic = 0;
+    int repeat = 3;
+    for (int i = 1; i < argc; ++i) {
+        auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* arg = argv[i];
+        const char* v = nullptr;
+        if (std::strcmp(arg, "--storage") == 0 && (v = value())) {
+            storage = v;
+        } else if (std::strcmp(arg, "--repeat") == 0 && (v = value())) {
+            repeat = std::max(1, std::atoi(v));
+        } else if (std::strcmp(arg, "--synthetic") == 0 && (v = value())) {
+            synthetic = static_cast<size_t>(std::strtoull(v, nullptr, 10));
+        } else if (std::strcmp(arg, "--write") == 0 && (v = value())) {
+            output = v;
+        } else if (arg[0] != '-' && input.empty()) {
+            input = arg;
+        } else {
+            return usage();
+        }
+    }
+    if (input.empty() == (synthetic == 0)) {
+        return usage();
+    }
+
+    rr::Trace trace;
+    try {
+        if (synthetic != 0) {
+            trace = synthesize(synthetic);
+            if (!output.empty()) {
+                std::ofstream out(output, std::ios::binary);
+                trace.write(out);
+                if (!out) {
+                    std::fprintf(stderr, "rr_replay: cannot write %s\n", output.c_str());
+                    return 1;
+                }
+            }
+        } else {
+            std::ifstream in(input, std::ios::binary);
+            if (!in) {
+                std::fprintf(stderr, "rr_replay: cannot open %s\n", input.c_str());
+                return 1;
+            }
+            trace = rr::Trace::read(in);
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "rr_replay: %s\n", e.what());
+        return 1;
+    }
+
+    Workload work = prepare(trace);
+    std::printf("%zu events (%llu dropped before capture), %zu selections, %zu items present at start\n\n",
+                work.events.size(), static_cast<unsigned long long>(trace.dropped), work.selections, work.initial.size());
+    std::printf("%-9s %12s %6s %6s %6s %7s %8s %8s %7s\n",
+                "storage", "events/s", "p50ns", "p90ns", "p99ns", "p99.9ns", "max ns", "jain", "items");
+
+    bool any = false;
+    auto run = [&](const char* name, auto measure_fn) {
+        if (storage == "all" || storage == name) {
+            print(name, measure_fn());
+            any = true;
+        }
+    };
+    run("list", [&] { return measure<rr::RoundRobin<uint32_t, rr::ListStorage>, false>(work, repeat); });
+    run("vector", [&] { return measure<rr::RoundRobin<uint32_t, rr::VectorStorage>, false>(work, repeat); });
+    run("weighted", [&] { return measure<rr::RoundRobin<uint32_t, rr::WeightedStorage>, true>(work, repeat); });
+    run("pooled", [&] { return measure<rr::PooledRoundRobin<uint32_t>, false>(work, repeat); });
+    if (!any) {
+        return usage();
+    }
+    return 0;
+}